@@ -6,7 +6,7 @@ const version = std.SemanticVersion.parse(zon.version) catch unreachable;
 // --- Source files ---
 
 const parser_source = "src/md4x.c";
-const renderer_sources = [_][]const u8{ "src/renderers/md4x-html.c", "src/renderers/md4x-ast.c", "src/renderers/md4x-ansi.c", "src/renderers/md4x-meta.c", "src/renderers/md4x-text.c", "src/renderers/md4x-markdown.c", "src/renderers/md4x-heal.c", "src/entity.c" };
+const renderer_sources = [_][]const u8{ "src/renderers/md4x-html.c", "src/renderers/md4x-ast.c", "src/renderers/md4x-ansi.c", "src/renderers/md4x-meta.c", "src/renderers/md4x-text.c", "src/renderers/md4x-markdown.c", "src/renderers/md4x-heal.c", "src/renderers/md4x-multi.c", "src/entity.c", "src/md4x-trace.c" };
 const cli_sources = renderer_sources ++ .{ "src/cli/md4x-cli.c", "src/cli/cmdline.c" };
 const wasm_sources = renderer_sources ++ .{"src/md4x-wasm.c"};
 const napi_sources = renderer_sources ++ .{"src/md4x-napi.c"};
@@ -34,6 +34,10 @@ const libyaml_c_flags: []const []const u8 = &.{
     "-DYAML_VERSION_STRING=\"0.2.5\"",
 };
 
+fn concatFlags(b: *std.Build, flags: []const []const u8, extra: []const []const u8) []const []const u8 {
+    return std.mem.concat(b.allocator, []const u8, &.{ flags, extra }) catch @panic("OOM");
+}
+
 // --- Build options passed to WASM/NAPI targets ---
 
 const PkgBuildOptions = struct {
@@ -41,12 +45,17 @@ const PkgBuildOptions = struct {
     strip: bool,
     libyaml_src: std.Build.Module.AddCSourceFilesOptions,
     include_paths: []const std.Build.LazyPath,
+    parser_flags: []const []const u8,
+    size_flags: []const []const u8,
 };
 
 pub fn build(b: *std.Build) void {
     const target = b.standardTargetOptions(.{});
     const optimize = b.option(std.builtin.OptimizeMode, "optimize", "Prioritize performance, safety, or binary size") orelse .ReleaseFast;
 
+    const trace = b.option(bool, "trace", "Record parser trace events for the CLI --trace option (Chrome trace JSON)") orelse false;
+    const wide_offsets = b.option(bool, "wide-offsets", "Use 64-bit sizes and offsets (MD_SIZE, MD_OFFSET) for documents larger than 4 GiB") orelse false;
+
     const strip = optimize != .Debug;
 
     const mod_opts: std.Build.Module.CreateOptions = .{
@@ -73,16 +82,27 @@ pub fn build(b: *std.Build) void {
         .name = "md4x",
         .root_module = b.createModule(mod_opts),
     });
-    exe.addCSourceFile(.{ .file = b.path(parser_source), .flags = c_flags_utf8 });
-    exe.addCSourceFiles(.{ .files = &cli_sources, .flags = c_flags });
+    // -Dtrace=true: instrument the parser and renderers (see src/md4x-trace.h)
+    const trace_flags: []const []const u8 = if (trace) &.{"-DMD4X_TRACE"} else &.{};
+    // -Dwide-offsets=true: every source including md4x.h must agree on MD_SIZE (see src/md4x.h)
+    const size_flags: []const []const u8 = if (wide_offsets) &.{"-DMD4X_WIDE_OFFSETS"} else &.{};
+    const parser_flags = concatFlags(b, c_flags_utf8, size_flags);
+    exe.addCSourceFile(.{ .file = b.path(parser_source), .flags = concatFlags(b, parser_flags, trace_flags) });
+    exe.addCSourceFiles(.{ .files = &cli_sources, .flags = concatFlags(b, concatFlags(b, c_flags, size_flags), trace_flags) });
     exe.addCSourceFiles(libyaml_src);
     for (include_paths) |p| exe.addIncludePath(p);
+    // --batch worker threads
+    if (target.result.os.tag != .windows) exe.linkSystemLibrary("pthread");
     b.installArtifact(exe);
 
     // --- Fuzzer targets ---
 
     addFuzzers(b);
 
+    // --- Benchmark harness ---
+
+    addBench(b, target, libyaml_src, include_paths, parser_flags, size_flags);
+
     // --- WASM & NAPI targets ---
 
     const pkg_optimize: std.builtin.OptimizeMode = .ReleaseFast;
@@ -91,6 +111,8 @@ pub fn build(b: *std.Build) void {
         .strip = pkg_optimize != .Debug,
         .libyaml_src = libyaml_src,
         .include_paths = include_paths,
+        .parser_flags = parser_flags,
+        .size_flags = size_flags,
     };
     _ = addWasm(b, pkg_opts);
     _ = addNapi(b, pkg_opts);
@@ -112,8 +134,8 @@ fn addWasm(b: *std.Build, opts: PkgBuildOptions) *std.Build.Step {
         }),
     });
     md4x_wasm.rdynamic = true;
-    md4x_wasm.addCSourceFile(.{ .file = b.path(parser_source), .flags = c_flags_utf8 });
-    md4x_wasm.addCSourceFiles(.{ .files = &wasm_sources, .flags = c_flags });
+    md4x_wasm.addCSourceFile(.{ .file = b.path(parser_source), .flags = opts.parser_flags });
+    md4x_wasm.addCSourceFiles(.{ .files = &wasm_sources, .flags = concatFlags(b, c_flags, opts.size_flags) });
     md4x_wasm.addCSourceFiles(opts.libyaml_src);
     for (opts.include_paths) |p| md4x_wasm.addIncludePath(p);
     md4x_wasm.root_module.export_symbol_names = &.{
@@ -121,12 +143,14 @@ fn addWasm(b: *std.Build, opts: PkgBuildOptions) *std.Build.Step {
         "md4x_free",
         "md4x_to_html",
         "md4x_to_html_meta",
+        "md4x_to_html_blocks",
         "md4x_to_ast",
         "md4x_to_ansi",
         "md4x_to_meta",
         "md4x_to_text",
         "md4x_to_markdown",
         "md4x_heal",
+        "md4x_render_all",
         "md4x_result_ptr",
         "md4x_result_size",
     };
@@ -186,8 +210,8 @@ fn addNapi(b: *std.Build, opts: PkgBuildOptions) *std.Build.Step {
                 .strip = opts.strip,
             }),
         });
-        napi_lib.addCSourceFile(.{ .file = b.path(parser_source), .flags = c_flags_utf8 });
-        napi_lib.addCSourceFiles(.{ .files = &napi_sources, .flags = napi_c_flags });
+        napi_lib.addCSourceFile(.{ .file = b.path(parser_source), .flags = opts.parser_flags });
+        napi_lib.addCSourceFiles(.{ .files = &napi_sources, .flags = concatFlags(b, napi_c_flags, opts.size_flags) });
         napi_lib.addCSourceFiles(opts.libyaml_src);
         for (opts.include_paths) |p| napi_lib.addIncludePath(p);
         napi_lib.addIncludePath(.{ .cwd_relative = napi_include });
@@ -219,6 +243,33 @@ fn addNapi(b: *std.Build, opts: PkgBuildOptions) *std.Build.Step {
     return napi_all_step;
 }
 
+fn addBench(b: *std.Build, target: std.Build.ResolvedTarget, libyaml_src: std.Build.Module.AddCSourceFilesOptions, include_paths: []const std.Build.LazyPath, parser_flags: []const []const u8, size_flags: []const []const u8) void {
+    // The library sources are compiled with bench-alloc.h force-included so
+    // their malloc()/calloc()/realloc() calls are counted by the harness.
+    const alloc_flags: []const []const u8 = &.{ "-include", "bench-alloc.h" };
+
+    const bench = b.addExecutable(.{
+        .name = "md4x-bench",
+        .root_module = b.createModule(.{
+            .target = target,
+            .optimize = .ReleaseFast,
+            .link_libc = true,
+        }),
+    });
+    bench.addCSourceFile(.{ .file = b.path(parser_source), .flags = concatFlags(b, parser_flags, alloc_flags) });
+    bench.addCSourceFiles(.{ .files = &renderer_sources, .flags = concatFlags(b, concatFlags(b, c_flags, size_flags), alloc_flags) });
+    bench.addCSourceFiles(.{ .root = libyaml_src.root, .files = libyaml_src.files, .flags = libyaml_c_flags ++ alloc_flags });
+    bench.addCSourceFile(.{ .file = b.path("test/bench/md4x-bench.c"), .flags = concatFlags(b, c_flags, size_flags) });
+    for (include_paths) |p| bench.addIncludePath(p);
+    bench.addIncludePath(b.path("test/bench"));
+
+    const run_bench = b.addRunArtifact(bench);
+    run_bench.setCwd(b.path("."));
+    if (b.args) |args| run_bench.addArgs(args);
+    const bench_step = b.step("bench", "Run the native benchmark and compare with test/bench/baseline.json");
+    bench_step.dependOn(&run_bench.step);
+}
+
 fn addFuzzers(b: *std.Build) void {
     const fuzz_build = b.addSystemCommand(&.{ "sh", "test/fuzzers/build.sh" });
     const fuzz_step = b.step("fuzz", "Build all fuzzer harnesses (requires clang)");
@@ -0,0 +1,96 @@
+import { bench, compact, run, summary } from "mitata";
+import * as napi from "../lib/napi.mjs";
+import * as wasm from "../lib/wasm/default.mjs";
+
+await wasm.init();
+await napi.init();
+
+// Documents that are mostly frontmatter. `flat` stays on the hand-written
+// scanner; `flow` carries the same data in flow style, which forces libyaml.
+const flat = `---
+title: Getting Started with md4x
+description: A fast markdown parser written in C with JS bindings
+author: Jane Doe
+date: 2026-01-15
+draft: false
+weight: 10
+category: guides
+slug: getting-started
+image: /images/cover.png
+canonical: https://example.com/docs/getting-started
+tags:
+  - markdown
+  - parser
+  - wasm
+  - napi
+navigation: true
+toc: true
+version: 1.2
+layout: docs
+---
+
+# Getting Started
+`;
+
+const flow = `---
+title: Getting Started with md4x
+description: A fast markdown parser written in C with JS bindings
+author: Jane Doe
+date: 2026-01-15
+draft: false
+weight: 10
+category: guides
+slug: getting-started
+image: /images/cover.png
+canonical: https://example.com/docs/getting-started
+tags: [markdown, parser, wasm, napi]
+navigation: true
+toc: true
+version: 1.2
+layout: docs
+---
+
+# Getting Started
+`;
+
+const components = Array.from(
+  { length: 20 },
+  (_, i) =>
+    `::card\n---\ntitle: Card ${i}\nicon: i-lucide-box\nto: /docs/${i}\n---\nBody ${i}\n::\n`,
+).join("\n");
+
+const inputs = { flat, flow };
+
+for (const [name, input] of Object.entries(inputs)) {
+  compact(() => {
+    summary(() => {
+      bench(`md4x-napi renderToMeta (${name})`, () => napi.renderToMeta(input));
+      bench(`md4x-wasm renderToMeta (${name})`, () => wasm.renderToMeta(input));
+    });
+    summary(() => {
+      bench(`md4x-napi renderToAST (${name})`, () => napi.renderToAST(input));
+      bench(`md4x-wasm renderToAST (${name})`, () => wasm.renderToAST(input));
+    });
+    summary(() => {
+      bench(`md4x-napi renderToHtml full (${name})`, () =>
+        napi.renderToHtml(input, { full: true }),
+      );
+      bench(`md4x-wasm renderToHtml full (${name})`, () =>
+        wasm.renderToHtml(input, { full: true }),
+      );
+    });
+  });
+}
+
+compact(() => {
+  summary(() => {
+    bench(`md4x-napi renderToHtml (component frontmatter)`, () =>
+      napi.renderToHtml(components),
+    );
+    bench(`md4x-wasm renderToHtml (component frontmatter)`, () =>
+      wasm.renderToHtml(components),
+    );
+  });
+});
+
+await run();
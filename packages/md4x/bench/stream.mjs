@@ -0,0 +1,162 @@
+// Streaming replay benchmark: feeds each fixture in 1-8 byte chunks (like LLM
+// tokens) and re-runs heal/render on the accumulated text after every chunk.
+//
+// Reports per message: total time, mean per-token time over the first and last
+// 10% of tokens (a growing ratio exposes quadratic behavior), and the UTF-8
+// bytes passed in and out. For WASM it also reports the buffers allocated
+// across the boundary, counted by instrumenting the exports: md4x_alloc()
+// copies of the input and the results read through md4x_result_size().
+
+import * as napi from "../lib/napi.mjs";
+import * as wasm from "../lib/wasm/default.mjs";
+import { _getExports, _setInstance } from "../lib/wasm/common.mjs";
+import * as fixtures from "./_fixtures.mjs";
+
+await wasm.init();
+await napi.init();
+
+const ROUNDS = Number(process.env.ROUNDS || 1);
+const encoder = new TextEncoder();
+
+// Route the WASM bindings through counting wrappers of the exports.
+const wasmExports = _getExports();
+const wasmCounts = { buffers: 0, bytes: 0 };
+_setInstance({
+  exports: {
+    ...wasmExports,
+    md4x_alloc(size) {
+      wasmCounts.buffers++;
+      wasmCounts.bytes += size;
+      return wasmExports.md4x_alloc(size);
+    },
+    md4x_result_size() {
+      const size = wasmExports.md4x_result_size();
+      wasmCounts.buffers++;
+      wasmCounts.bytes += size;
+      return size;
+    },
+  },
+});
+
+// Deterministic 1-8 byte chunks that never split a UTF-8 sequence.
+function tokenize(input, seed = 0x9e3779b9) {
+  const tokens = [];
+  let token = "";
+  let tokenBytes = 0;
+  let size = 0;
+  for (const ch of input) {
+    if (tokenBytes === 0) {
+      seed = (Math.imul(seed, 1103515245) + 12345) >>> 0;
+      size = 1 + ((seed >>> 16) % 8);
+    }
+    token += ch;
+    tokenBytes += encoder.encode(ch).length;
+    if (tokenBytes >= size) {
+      tokens.push(token);
+      token = "";
+      tokenBytes = 0;
+    }
+  }
+  if (token) tokens.push(token);
+  return tokens;
+}
+
+function replay(fn, tokens) {
+  const times = new Float64Array(tokens.length);
+  let text = "";
+  let textBytes = 0;
+  let inBytes = 0;
+  let outBytes = 0;
+  let total = 0;
+  const buffers = wasmCounts.buffers;
+  const bytes = wasmCounts.bytes;
+  for (let i = 0; i < tokens.length; i++) {
+    text += tokens[i];
+    textBytes += encoder.encode(tokens[i]).length;
+    const t0 = performance.now();
+    const out = fn(text);
+    times[i] = performance.now() - t0;
+    total += times[i];
+    inBytes += textBytes;
+    outBytes += encoder.encode(out).length;
+  }
+  return {
+    total,
+    times,
+    inBytes,
+    outBytes,
+    wasmBuffers: wasmCounts.buffers - buffers,
+    wasmBytes: wasmCounts.bytes - bytes,
+  };
+}
+
+function mean(arr, from, to) {
+  let sum = 0;
+  for (let i = from; i < to; i++) sum += arr[i];
+  return sum / Math.max(1, to - from);
+}
+
+function fmtTime(ms) {
+  if (ms >= 1) return `${ms.toFixed(2)} ms`;
+  return `${(ms * 1000).toFixed(2)} µs`;
+}
+
+function fmtBytes(n) {
+  if (n >= 1 << 20) return `${(n / (1 << 20)).toFixed(1)} MiB`;
+  return `${(n / 1024).toFixed(1)} KiB`;
+}
+
+const targets = {
+  napi: napi,
+  wasm: wasm,
+};
+
+const ops = {
+  heal: (api) => (s) => api.heal(s),
+  "renderToHtml({heal})": (api) => (s) => api.renderToHtml(s, { heal: true }),
+  "renderToAST({heal})": (api) => (s) => api.renderToAST(s, { heal: true }),
+};
+
+const inputs = {
+  small: fixtures.small,
+  medium: fixtures.medium,
+  large: fixtures.large,
+};
+
+for (const [name, input] of Object.entries(inputs)) {
+  const tokens = tokenize(input);
+  const tail = Math.max(1, Math.floor(tokens.length / 10));
+  console.log(
+    `\n${name}: ${fmtBytes(encoder.encode(input).length)}, ${tokens.length} tokens`,
+  );
+  const rows = [];
+  for (const [opName, makeFn] of Object.entries(ops)) {
+    for (const [targetName, api] of Object.entries(targets)) {
+      const fn = makeFn(api);
+      replay(fn, tokens.slice(0, tail)); // warmup
+      let best;
+      for (let r = 0; r < ROUNDS; r++) {
+        const res = replay(fn, tokens);
+        if (!best || res.total < best.total) best = res;
+      }
+      const first = mean(best.times, 0, tail);
+      const last = mean(best.times, tokens.length - tail, tokens.length);
+      rows.push({
+        benchmark: `md4x-${targetName} ${opName}`,
+        "total/msg": fmtTime(best.total),
+        "first 10%/tok": fmtTime(first),
+        "last 10%/tok": fmtTime(last),
+        growth: `${(last / first).toFixed(1)}x`,
+        "in+out bytes": fmtBytes(best.inBytes + best.outBytes),
+        "wasm buffers": targetName === "wasm" ? best.wasmBuffers : "-",
+        "wasm buffer bytes":
+          targetName === "wasm" ? fmtBytes(best.wasmBytes) : "-",
+      });
+    }
+  }
+  console.table(rows);
+}
+
+// Linear memory never shrinks, so its size is the peak heap of the run.
+const wasmMemory = _getExports().memory.buffer.byteLength;
+console.log(`\nwasm linear memory (high-water): ${fmtBytes(wasmMemory)}`);
@@ -113,3 +113,189 @@ export function parseAnsiWithHighlighting(bytes, highlighter) {
   out += ansi.slice(pos);
   return out;
 }
+
+// --- HTML block patches ---
+
+export function parseHtmlBlocks(bytes) {
+  const nullIdx = bytes.indexOf(0);
+  if (nullIdx === -1) {
+    return bytes.length > 0 ? [decoder.decode(bytes)] : [];
+  }
+  const ends = JSON.parse(decoder.decode(bytes.subarray(nullIdx + 1)));
+  const blocks = [];
+  let pos = 0;
+  for (const end of ends) {
+    blocks.push(decoder.decode(bytes.subarray(pos, end)));
+    pos = end;
+  }
+  return blocks;
+}
+
+const CLOSE_TAGS_RE = /(?:<\/[A-Za-z][\w-]*>)+\n?$/;
+const UNKNOWN_ENTITY_RE = /&(?!amp;|lt;|gt;|quot;)/;
+
+// Returns the text appended to the innermost open element of `prev`, if that
+// is the only difference from `next`.
+function appendedText(prev, next) {
+  const m = CLOSE_TAGS_RE.exec(prev);
+  if (!m) return;
+  const body = prev.slice(0, m.index);
+  const tail = m[0];
+  if (body.endsWith(">") || next.length <= prev.length) return;
+  if (!next.startsWith(body) || !next.endsWith(tail)) return;
+  const added = next.slice(body.length, next.length - tail.length);
+  if (added.includes("<") || UNKNOWN_ENTITY_RE.test(added)) return;
+  return unescapeHtml(added);
+}
+
+export function diffHtmlBlocks(prev, next) {
+  const ops = [];
+  const n = Math.min(prev.length, next.length);
+  let i = 0;
+  while (i < n && prev[i] === next[i]) i++;
+  if (i === prev.length) {
+    if (i < next.length) ops.push({ type: "append", blocks: next.slice(i) });
+    return ops;
+  }
+  if (i === prev.length - 1 && i < next.length) {
+    const text = appendedText(prev[i], next[i]);
+    if (text !== undefined) {
+      ops.push({ type: "text", text, block: next[i] });
+      if (i + 1 < next.length) {
+        ops.push({ type: "append", blocks: next.slice(i + 1) });
+      }
+      return ops;
+    }
+  }
+  ops.push({ type: "replace", count: prev.length - i, blocks: next.slice(i) });
+  return ops;
+}
+
+const patchState = new WeakMap();
+
+function appendBlocks(container, counts, blocks) {
+  const tpl = container.ownerDocument.createElement("template");
+  for (const html of blocks) {
+    tpl.innerHTML = html;
+    counts.push(tpl.content.childNodes.length);
+    container.append(tpl.content);
+  }
+}
+
+function removeBlocks(container, counts, count) {
+  let nodes = 0;
+  for (let i = 0; i < count && counts.length > 0; i++) nodes += counts.pop();
+  for (; nodes > 0 && container.lastChild; nodes--) {
+    container.lastChild.remove();
+  }
+}
+
+function appendToLastText(container, counts, text) {
+  const count = counts.at(-1) || 0;
+  let node = container.lastChild;
+  for (let i = 1; i < count && node && node.nodeType !== 1; i++) {
+    node = node.previousSibling;
+  }
+  if (!node || node.nodeType !== 1) return false;
+  while (node.lastChild?.nodeType === 1) node = node.lastChild;
+  if (node.lastChild?.nodeType !== 3) return false;
+  node.lastChild.appendData(text);
+  return true;
+}
+
+export function applyHtmlPatch(container, ops) {
+  let counts = patchState.get(container);
+  if (!counts) patchState.set(container, (counts = []));
+  for (const op of ops) {
+    switch (op.type) {
+      case "append": {
+        appendBlocks(container, counts, op.blocks);
+        break;
+      }
+      case "replace": {
+        removeBlocks(container, counts, op.count);
+        appendBlocks(container, counts, op.blocks);
+        break;
+      }
+      case "text": {
+        if (!appendToLastText(container, counts, op.text)) {
+          removeBlocks(container, counts, 1);
+          appendBlocks(container, counts, [op.block]);
+        }
+        break;
+      }
+    }
+  }
+}
+
+// --- Multi-format rendering ---
+
+// Index = MD_RENDER_FORMAT value in md4x-multi.h
+const RENDER_FORMATS = ["html", "ast", "meta", "text", "ansi", "markdown"];
+
+export function renderFormatsMask(formats) {
+  let mask = 0;
+  for (const format of formats) {
+    const idx = RENDER_FORMATS.indexOf(format);
+    if (idx === -1) {
+      throw new TypeError(`md4x: unsupported renderAll format "${format}"`);
+    }
+    mask |= 1 << idx;
+  }
+  return mask;
+}
+
+// renderAll() binding flag: append the MD_PARSE_STATS fields to the outputs.
+export const STATS_FLAG = 0x10000;
+
+// `limits` render option as the bindings take it: the MD_LIMITS fields
+// in declaration order, 0 meaning unlimited. The unsigned fields are clamped
+// here; maxOutputBytes and maxSteps (unsigned long and unsigned long long)
+// pass as numbers and the bindings clamp them to their C type.
+export function renderLimits(limits) {
+  const count = (v) => (Number(v) > 0 ? Math.floor(Number(v)) : 0);
+  return [
+    Math.min(count(limits.maxDepth), 0xffff_ffff),
+    Math.min(count(limits.maxMarks), 0xffff_ffff),
+    Math.min(count(limits.maxBlocks), 0xffff_ffff),
+    count(limits.maxOutputBytes),
+    count(limits.maxSteps),
+  ];
+}
+
+// MD_PARSE_STATS fields, in declaration order.
+const STATS_COUNTS = [
+  "lines",
+  "blocks",
+  "containers",
+  "marks",
+  "rollbacks",
+  "refDefs",
+  "reallocs",
+  "peakBlockBytes",
+  "peakContainerBytes",
+  "peakMarkBytes",
+  "peakBufferBytes",
+];
+const STATS_PHASES = ["blocks", "refDefs", "marks", "resolve", "emit"];
+
+export function renderAllResult(mask, outputs) {
+  const result = {};
+  let i = 0;
+  for (let idx = 0; idx < RENDER_FORMATS.length; idx++) {
+    if (mask & (1 << idx)) result[RENDER_FORMATS[idx]] = outputs[i++];
+  }
+  if (i < outputs.length) {
+    const values = outputs[i];
+    const stats = { timings: {} };
+    for (let j = 0; j < STATS_COUNTS.length; j++) {
+      stats[STATS_COUNTS[j]] = values[j];
+    }
+    // Nanoseconds per phase, reported in milliseconds
+    for (let j = 0; j < STATS_PHASES.length; j++) {
+      stats.timings[STATS_PHASES[j]] = values[STATS_COUNTS.length + j] / 1e6;
+    }
+    result.stats = stats;
+  }
+  return result;
+}
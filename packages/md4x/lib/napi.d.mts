@@ -4,6 +4,13 @@ import type {
   HtmlOptions,
   AnsiOptions,
   RenderOptions,
+  HealOptions,
+  HtmlPatchOp,
+  HtmlPatchResult,
+  RenderFormat,
+  RenderAllOptions,
+  RenderAllResult,
+  ParseStats,
 } from "./types.mjs";
 
 export type {
@@ -17,20 +24,54 @@ export type {
   HtmlOptions,
   AnsiOptions,
   RenderOptions,
+  HealOptions,
+  HtmlPatchOp,
+  HtmlPatchResult,
+  RenderFormat,
+  RenderAllOptions,
+  RenderAllResult,
+  ParseStats,
+  RenderLimits,
 } from "./types.mjs";
 
 export type * from "./types.mjs";
 
+/** MD_LIMITS fields in declaration order (0 = unlimited). */
+type BindingLimits = number[];
+
 export interface NAPIBinding {
-  renderToHtml(input: string, flags?: number): string;
-  renderToHtmlMeta(input: string): Buffer;
-  renderToAST(input: string, flags?: number): string;
-  renderToAnsi(input: string, flags?: number): string;
-  renderToAnsiMeta(input: string): Buffer;
-  renderToMeta(input: string, flags?: number): string;
-  renderToText(input: string, flags?: number): string;
-  renderToMarkdown(input: string, flags?: number): string;
-  heal(input: string): string;
+  renderToHtml(input: string, flags?: number, limits?: BindingLimits): string;
+  renderToHtmlMeta(
+    input: string,
+    flags?: number,
+    limits?: BindingLimits,
+  ): Buffer;
+  renderToHtmlBlocks(
+    input: string,
+    flags?: number,
+    limits?: BindingLimits,
+  ): Buffer;
+  renderToAST(input: string, flags?: number, limits?: BindingLimits): string;
+  renderToAnsi(input: string, flags?: number, limits?: BindingLimits): string;
+  renderToAnsiMeta(
+    input: string,
+    flags?: number,
+    limits?: BindingLimits,
+  ): Buffer;
+  renderToMeta(input: string, flags?: number, limits?: BindingLimits): string;
+  renderToText(input: string, flags?: number, limits?: BindingLimits): string;
+  renderToMarkdown(
+    input: string,
+    flags?: number,
+    limits?: BindingLimits,
+  ): string;
+  heal(input: string, limits?: BindingLimits): string;
+  renderAll(
+    input: string,
+    formats: number,
+    flags?: number,
+    limits?: BindingLimits,
+  ): Array<string | number[]>;
 }
 
 export interface InitOptions {
@@ -39,6 +80,19 @@ export interface InitOptions {
 
 export declare function init(opts?: InitOptions): Promise<void>;
 export declare function renderToHtml(input: string, opts?: HtmlOptions): string;
+export declare function renderToHtmlBlocks(
+  input: string,
+  opts?: RenderOptions,
+): string[];
+export declare function renderToHtmlPatch(
+  input: string,
+  prev?: string[],
+  opts?: RenderOptions,
+): HtmlPatchResult;
+export declare function applyHtmlPatch(
+  container: ParentNode & Node,
+  ops: HtmlPatchOp[],
+): void;
 export declare function renderToAST(
   input: string,
   opts?: RenderOptions,
@@ -64,4 +118,9 @@ export declare function renderToMarkdown(
   input: string,
   opts?: RenderOptions,
 ): string;
-export declare function heal(input: string): string;
+export declare function heal(input: string, opts?: HealOptions): string;
+export declare function renderAll<F extends RenderFormat>(
+  input: string,
+  formats: readonly F[],
+  opts?: RenderAllOptions,
+): RenderAllResult<F>;
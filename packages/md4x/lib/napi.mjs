@@ -1,8 +1,16 @@
 import {
   parseHtmlWithHighlighting,
   parseAnsiWithHighlighting,
+  parseHtmlBlocks,
+  diffHtmlBlocks,
+  renderFormatsMask,
+  renderAllResult,
+  renderLimits,
+  STATS_FLAG,
 } from "./_shared.mjs";
 
+export { applyHtmlPatch } from "./_shared.mjs";
+
 // --- internal ---
 
 let binding;
@@ -14,6 +22,11 @@ function str(input) {
   return input;
 }
 
+// `limits` option as the binding takes it (undefined: unlimited)
+function limits(opts) {
+  return opts?.limits ? renderLimits(opts.limits) : undefined;
+}
+
 function getBinding(opts) {
   if (binding) return binding;
   if (opts?.binding) {
@@ -46,18 +59,31 @@ export function renderToHtml(input, opts) {
   let flags = opts?.full ? 0x0008 : 0;
   if (opts?.heal) flags |= HEAL_FLAG;
   if (!opts?.highlighter) {
-    return getBinding().renderToHtml(str(input), flags);
+    return getBinding().renderToHtml(str(input), flags, limits(opts));
   }
-  const buf = getBinding().renderToHtmlMeta(str(input));
+  const buf = getBinding().renderToHtmlMeta(str(input), 0, limits(opts));
   return parseHtmlWithHighlighting(
     new Uint8Array(buf.buffer, buf.byteOffset, buf.byteLength),
     opts.highlighter,
   );
 }
 
+export function renderToHtmlBlocks(input, opts) {
+  const flags = opts?.heal ? HEAL_FLAG : 0;
+  const buf = getBinding().renderToHtmlBlocks(str(input), flags, limits(opts));
+  return parseHtmlBlocks(
+    new Uint8Array(buf.buffer, buf.byteOffset, buf.byteLength),
+  );
+}
+
+export function renderToHtmlPatch(input, prev, opts) {
+  const blocks = renderToHtmlBlocks(input, opts);
+  return { ops: diffHtmlBlocks(prev || [], blocks), blocks };
+}
+
 export function renderToAST(input, opts) {
   const flags = opts?.heal ? HEAL_FLAG : 0;
-  return getBinding().renderToAST(str(input), flags);
+  return getBinding().renderToAST(str(input), flags, limits(opts));
 }
 
 export function parseAST(input, opts) {
@@ -69,10 +95,13 @@ export function renderToAnsi(input, opts) {
   if (opts?.showUrls) flags |= 0x0010;
   if (opts?.showFrontmatter) flags |= 0x0020;
   if (!opts?.highlighter) {
-    return getBinding().renderToAnsi(str(input), flags);
+    return getBinding().renderToAnsi(str(input), flags, limits(opts));
   }
-  const s = opts?.heal ? getBinding().heal(str(input)) : str(input);
-  const buf = getBinding().renderToAnsiMeta(s);
+  const buf = getBinding().renderToAnsiMeta(
+    str(input),
+    flags & HEAL_FLAG,
+    limits(opts),
+  );
   return parseAnsiWithHighlighting(
     new Uint8Array(buf.buffer, buf.byteOffset, buf.byteLength),
     opts.highlighter,
@@ -81,17 +110,17 @@ export function renderToAnsi(input, opts) {
 
 export function renderToMeta(input, opts) {
   const flags = opts?.heal ? HEAL_FLAG : 0;
-  return getBinding().renderToMeta(str(input), flags);
+  return getBinding().renderToMeta(str(input), flags, limits(opts));
 }
 
 export function renderToText(input, opts) {
   const flags = opts?.heal ? HEAL_FLAG : 0;
-  return getBinding().renderToText(str(input), flags);
+  return getBinding().renderToText(str(input), flags, limits(opts));
 }
 
 export function renderToMarkdown(input, opts) {
   const flags = opts?.heal ? HEAL_FLAG : 0;
-  return getBinding().renderToMarkdown(str(input), flags);
+  return getBinding().renderToMarkdown(str(input), flags, limits(opts));
 }
 
 export function parseMeta(input, opts) {
@@ -102,6 +131,15 @@ export function parseMeta(input, opts) {
   return meta;
 }
 
-export function heal(input) {
-  return getBinding().heal(str(input));
+export function heal(input, opts) {
+  return getBinding().heal(str(input), limits(opts));
+}
+
+export function renderAll(input, formats, opts) {
+  const mask = renderFormatsMask(formats);
+  if (mask === 0 && !opts?.stats) return {};
+  let flags = opts?.heal ? HEAL_FLAG : 0;
+  if (opts?.stats) flags |= STATS_FLAG;
+  const outputs = getBinding().renderAll(str(input), mask, flags, limits(opts));
+  return renderAllResult(mask, outputs);
 }
@@ -32,6 +32,19 @@ export type ComarkMeta = {
 export interface RenderOptions {
   /** Heal incomplete/streaming Markdown before rendering. */
   heal?: boolean;
+  /**
+   * Resource budgets for untrusted input. When the document exceeds any of
+   * them, rendering throws an error with code `"MD4X_LIMIT_EXCEEDED"`.
+   */
+  limits?: RenderLimits;
+}
+
+export interface HealOptions {
+  /**
+   * Healing does not parse the document, so only `maxOutputBytes` applies,
+   * to the healed output.
+   */
+  limits?: Pick<RenderLimits, "maxOutputBytes">;
 }
 
 export interface AnsiOptions extends RenderOptions {
@@ -105,3 +118,89 @@ export type AnsiCodeBlockHighlighter = (
   /** Code block metadata (lang, filename, highlights, offsets) */
   block: AnsiCodeBlock,
 ) => string | undefined;
+
+export type HtmlPatchOp =
+  /** Append new top-level blocks after the existing ones. */
+  | { type: "append"; blocks: string[] }
+  /** Remove the last `count` top-level blocks, then append `blocks`. */
+  | { type: "replace"; count: number; blocks: string[] }
+  /**
+   * Append plain text to the last text node of the last block. `block` is the
+   * full new HTML of that block, used as a fallback when the DOM has diverged.
+   */
+  | { type: "text"; text: string; block: string };
+
+export interface HtmlPatchResult {
+  /** Patch operations transforming the previous blocks into `blocks` */
+  ops: HtmlPatchOp[];
+  /** HTML of each top-level block; pass back as `prev` on the next call */
+  blocks: string[];
+}
+
+/** Output formats supported by `renderAll` (one shared parse). */
+export type RenderFormat =
+  | "html"
+  | "ast"
+  | "meta"
+  | "text"
+  | "ansi"
+  | "markdown";
+
+export interface RenderAllOptions extends RenderOptions {
+  /** Also report parser statistics (`stats` in the result). */
+  stats?: boolean;
+}
+
+/** Resource budgets of one render call (`MD_LIMITS`). Unset or 0 means unlimited. */
+export interface RenderLimits {
+  /** Nesting of container blocks (block quotes, lists, list items, components, ...). */
+  maxDepth?: number;
+  /** Inline marks, summed over all leaf blocks. */
+  maxMarks?: number;
+  /** Leaf and container blocks. */
+  maxBlocks?: number;
+  /** Size of all text content emitted by the parser, in bytes. */
+  maxOutputBytes?: number;
+  /** Work units: lines, blocks, marks and mark rollbacks. */
+  maxSteps?: number;
+}
+
+/** Parser statistics of one `renderAll` call (`MD_PARSE_STATS`). */
+export interface ParseStats {
+  /** Lines analyzed by the block parser. */
+  lines: number;
+  /** Leaf blocks (paragraphs, headings, code blocks, tables, ...). */
+  blocks: number;
+  /** Container blocks (block quotes, lists, list items, components, ...). */
+  containers: number;
+  /** Inline marks collected, summed over all leaf blocks. */
+  marks: number;
+  /** Mark rollbacks while resolving links and emphasis. */
+  rollbacks: number;
+  /** Link reference definitions. */
+  refDefs: number;
+  /** Reallocations growing the internal buffers. */
+  reallocs: number;
+  /** Peak sizes of the internal buffers, in bytes. */
+  peakBlockBytes: number;
+  peakContainerBytes: number;
+  peakMarkBytes: number;
+  peakBufferBytes: number;
+  /** Time spent in each parser phase, in milliseconds. */
+  timings: {
+    blocks: number;
+    refDefs: number;
+    marks: number;
+    resolve: number;
+    /** Emitting the document, including the renderers. */
+    emit: number;
+  };
+}
+
+/** Raw output strings keyed by format (`ast` and `meta` are JSON strings). */
+export type RenderAllResult<F extends RenderFormat = RenderFormat> = {
+  [K in F]: string;
+} & {
+  /** Present with the `stats` option. */
+  stats?: ParseStats;
+};
@@ -1,8 +1,16 @@
 import {
   parseHtmlWithHighlighting,
   parseAnsiWithHighlighting,
+  parseHtmlBlocks,
+  diffHtmlBlocks,
+  renderFormatsMask,
+  renderAllResult,
+  renderLimits,
+  STATS_FLAG,
 } from "../_shared.mjs";
 
+export { applyHtmlPatch } from "../_shared.mjs";
+
 // --- internal ---
 
 let _instance;
@@ -33,6 +41,12 @@ export const _imports = {
     fd_seek: () => 0,
     fd_write: () => 0,
     proc_exit: () => {},
+    // Monotonic clock for parser stats (renderAll with `stats: true`)
+    clock_time_get: (_id, _precision, ptr) => {
+      const ns = BigInt(Math.round(performance.now() * 1e6));
+      new DataView(_instance.exports.memory.buffer).setBigUint64(ptr, ns, true);
+      return 0;
+    },
     random_get: (buf, len) => {
       const bytes = new Uint8Array(_instance.exports.memory.buffer, buf, len);
       crypto.getRandomValues(bytes);
@@ -48,6 +62,25 @@ function str(input) {
   return input;
 }
 
+// MD_LIMIT_EXCEEDED in md4x.h
+const LIMIT_EXCEEDED = -2;
+
+function checkResult(ret) {
+  if (ret === LIMIT_EXCEEDED) {
+    throw Object.assign(new Error("md4x: limits exceeded"), {
+      code: "MD4X_LIMIT_EXCEEDED",
+    });
+  }
+  if (ret !== 0) {
+    throw new Error("md4x: render failed");
+  }
+}
+
+// `limits` option as the exports take it (trailing arguments)
+function limits(opts) {
+  return renderLimits(opts?.limits || {});
+}
+
 function render(exports, fn, input, ...extra) {
   const { memory, md4x_alloc, md4x_free, md4x_result_ptr, md4x_result_size } =
     exports;
@@ -56,9 +89,7 @@ function render(exports, fn, input, ...extra) {
   new Uint8Array(memory.buffer).set(encoded, ptr);
   const ret = fn(ptr, encoded.length, ...extra);
   md4x_free(ptr);
-  if (ret !== 0) {
-    throw new Error("md4x: render failed");
-  }
+  checkResult(ret);
   const outPtr = md4x_result_ptr();
   const outSize = md4x_result_size();
   const result = new TextDecoder().decode(
@@ -69,17 +100,15 @@ function render(exports, fn, input, ...extra) {
 }
 
 /* Render with a meta function, returning raw bytes for highlighter processing. */
-function renderMetaBytes(exports, metaFn, input) {
+function renderMetaBytes(exports, metaFn, input, ...extra) {
   const { memory, md4x_alloc, md4x_free, md4x_result_ptr, md4x_result_size } =
     exports;
   const encoded = new TextEncoder().encode(str(input));
   const ptr = md4x_alloc(encoded.length);
   new Uint8Array(memory.buffer).set(encoded, ptr);
-  const ret = metaFn(ptr, encoded.length);
+  const ret = metaFn(ptr, encoded.length, ...extra);
   md4x_free(ptr);
-  if (ret !== 0) {
-    throw new Error("md4x: render failed");
-  }
+  checkResult(ret);
   const outPtr = md4x_result_ptr();
   const outSize = md4x_result_size();
   const bytes = new Uint8Array(memory.buffer, outPtr, outSize);
@@ -93,22 +122,44 @@ export function renderToHtml(input, opts) {
   if (opts?.heal) flags |= HEAL_FLAG;
   const exports = _getExports();
   if (!opts?.highlighter) {
-    return render(exports, exports.md4x_to_html, input, flags);
+    return render(exports, exports.md4x_to_html, input, flags, ...limits(opts));
   }
   const { bytes, outPtr } = renderMetaBytes(
     exports,
     exports.md4x_to_html_meta,
     input,
+    0,
+    ...limits(opts),
   );
   const result = parseHtmlWithHighlighting(bytes, opts.highlighter);
   exports.md4x_free(outPtr);
   return result;
 }
 
+export function renderToHtmlBlocks(input, opts) {
+  const flags = opts?.heal ? HEAL_FLAG : 0;
+  const exports = _getExports();
+  const { bytes, outPtr } = renderMetaBytes(
+    exports,
+    exports.md4x_to_html_blocks,
+    input,
+    flags,
+    ...limits(opts),
+  );
+  const result = parseHtmlBlocks(bytes);
+  exports.md4x_free(outPtr);
+  return result;
+}
+
+export function renderToHtmlPatch(input, prev, opts) {
+  const blocks = renderToHtmlBlocks(input, opts);
+  return { ops: diffHtmlBlocks(prev || [], blocks), blocks };
+}
+
 export function renderToAST(input, opts) {
   const flags = opts?.heal ? HEAL_FLAG : 0;
   const exports = _getExports();
-  return render(exports, exports.md4x_to_ast, input, flags);
+  return render(exports, exports.md4x_to_ast, input, flags, ...limits(opts));
 }
 
 export function parseAST(input, opts) {
@@ -121,13 +172,14 @@ export function renderToAnsi(input, opts) {
   if (opts?.showFrontmatter) flags |= 0x0020;
   const exports = _getExports();
   if (!opts?.highlighter) {
-    return render(exports, exports.md4x_to_ansi, input, flags);
+    return render(exports, exports.md4x_to_ansi, input, flags, ...limits(opts));
   }
-  const s = opts?.heal ? heal(str(input)) : str(input);
   const { bytes, outPtr } = renderMetaBytes(
     exports,
     exports.md4x_to_ansi_meta,
-    s,
+    input,
+    flags & HEAL_FLAG,
+    ...limits(opts),
   );
   const result = parseAnsiWithHighlighting(bytes, opts.highlighter);
   exports.md4x_free(outPtr);
@@ -137,19 +189,25 @@ export function renderToAnsi(input, opts) {
 export function renderToMeta(input, opts) {
   const flags = opts?.heal ? HEAL_FLAG : 0;
   const exports = _getExports();
-  return render(exports, exports.md4x_to_meta, input, flags);
+  return render(exports, exports.md4x_to_meta, input, flags, ...limits(opts));
 }
 
 export function renderToText(input, opts) {
   const flags = opts?.heal ? HEAL_FLAG : 0;
   const exports = _getExports();
-  return render(exports, exports.md4x_to_text, input, flags);
+  return render(exports, exports.md4x_to_text, input, flags, ...limits(opts));
 }
 
 export function renderToMarkdown(input, opts) {
   const flags = opts?.heal ? HEAL_FLAG : 0;
   const exports = _getExports();
-  return render(exports, exports.md4x_to_markdown, input, flags);
+  return render(
+    exports,
+    exports.md4x_to_markdown,
+    input,
+    flags,
+    ...limits(opts),
+  );
 }
 
 export function parseMeta(input, opts) {
@@ -160,7 +218,45 @@ export function parseMeta(input, opts) {
   return meta;
 }
 
-export function heal(input) {
+export function heal(input, opts) {
   const exports = _getExports();
-  return render(exports, exports.md4x_heal, input);
+  // Only maxOutputBytes applies: healing does not parse
+  return render(exports, exports.md4x_heal, input, limits(opts)[3]);
+}
+
+export function renderAll(input, formats, opts) {
+  const mask = renderFormatsMask(formats);
+  if (mask === 0 && !opts?.stats) return {};
+  let flags = opts?.heal ? HEAL_FLAG : 0;
+  if (opts?.stats) flags |= STATS_FLAG;
+  const exports = _getExports();
+  const { bytes, outPtr } = renderMetaBytes(
+    exports,
+    exports.md4x_render_all,
+    input,
+    mask,
+    flags,
+    ...limits(opts),
+  );
+  // Layout: u32 size per selected format (and the stats), then the
+  // concatenated outputs
+  const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+  const count = countBits(mask) + (opts?.stats ? 1 : 0);
+  const decoder = new TextDecoder();
+  const outputs = [];
+  let pos = count * 4;
+  for (let i = 0; i < count; i++) {
+    const size = view.getUint32(i * 4, true);
+    outputs.push(decoder.decode(bytes.subarray(pos, pos + size)));
+    pos += size;
+  }
+  exports.md4x_free(outPtr);
+  if (opts?.stats) outputs.push(JSON.parse(outputs.pop()));
+  return renderAllResult(mask, outputs);
+}
+
+function countBits(n) {
+  let count = 0;
+  for (; n; n &= n - 1) count++;
+  return count;
 }
@@ -4,6 +4,13 @@ import type {
   HtmlOptions,
   AnsiOptions,
   RenderOptions,
+  HealOptions,
+  HtmlPatchOp,
+  HtmlPatchResult,
+  RenderFormat,
+  RenderAllOptions,
+  RenderAllResult,
+  ParseStats,
 } from "../types.mjs";
 
 export type {
@@ -17,6 +24,14 @@ export type {
   HtmlOptions,
   AnsiOptions,
   RenderOptions,
+  HealOptions,
+  HtmlPatchOp,
+  HtmlPatchResult,
+  RenderFormat,
+  RenderAllOptions,
+  RenderAllResult,
+  ParseStats,
+  RenderLimits,
 } from "../types.mjs";
 
 export interface InitOptions {
@@ -30,6 +45,19 @@ export interface InitOptions {
 
 export declare function init(opts?: InitOptions): Promise<void>;
 export declare function renderToHtml(input: string, opts?: HtmlOptions): string;
+export declare function renderToHtmlBlocks(
+  input: string,
+  opts?: RenderOptions,
+): string[];
+export declare function renderToHtmlPatch(
+  input: string,
+  prev?: string[],
+  opts?: RenderOptions,
+): HtmlPatchResult;
+export declare function applyHtmlPatch(
+  container: ParentNode & Node,
+  ops: HtmlPatchOp[],
+): void;
 export declare function renderToAST(
   input: string,
   opts?: RenderOptions,
@@ -55,4 +83,9 @@ export declare function renderToMarkdown(
   input: string,
   opts?: RenderOptions,
 ): string;
-export declare function heal(input: string): string;
+export declare function heal(input: string, opts?: HealOptions): string;
+export declare function renderAll<F extends RenderFormat>(
+  input: string,
+  formats: readonly F[],
+  opts?: RenderAllOptions,
+): RenderAllResult<F>;
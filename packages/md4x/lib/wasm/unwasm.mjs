@@ -1,5 +1,8 @@
 export {
   renderToHtml,
+  renderToHtmlBlocks,
+  renderToHtmlPatch,
+  applyHtmlPatch,
   renderToAST,
   parseAST,
   renderToAnsi,
@@ -8,6 +11,7 @@ export {
   renderToText,
   renderToMarkdown,
   heal,
+  renderAll,
 } from "./common.mjs";
 
 import { _setInstance, _hasInstance, _imports } from "./common.mjs";
@@ -0,0 +1,174 @@
+// Minimal DOM for applyHtmlPatch() tests: elements, text and comment nodes,
+// and <template> parsing of the HTML md4x renders. Attributes are kept as
+// written; text is decoded and re-escaped, so two trees built from the same
+// markup serialize to the same innerHTML.
+
+const VOID_TAGS = new Set(["area", "br", "col", "hr", "img", "input", "wbr"]);
+const TOKEN_RE =
+  /<!--[\s\S]*?-->|<\/([A-Za-z][\w-]*)\s*>|<([A-Za-z][\w-]*)((?:[^>"']|"[^"]*"|'[^']*')*)>|[^<]+|</g;
+const ENTITIES = { amp: "&", lt: "<", gt: ">", quot: '"', apos: "'" };
+
+function decode(text) {
+  return text.replace(/&(#x[\da-f]+|#\d+|\w+);/gi, (m, name) => {
+    if (name[0] !== "#") return ENTITIES[name] ?? m;
+    const hex = name[1] === "x" || name[1] === "X";
+    return String.fromCodePoint(
+      Number.parseInt(name.slice(hex ? 2 : 1), hex ? 16 : 10),
+    );
+  });
+}
+
+function escape(text) {
+  return text
+    .replaceAll("&", "&amp;")
+    .replaceAll("<", "&lt;")
+    .replaceAll(">", "&gt;");
+}
+
+class Node {
+  parentNode = null;
+
+  get previousSibling() {
+    const siblings = this.parentNode?.childNodes;
+    return siblings?.[siblings.indexOf(this) - 1] ?? null;
+  }
+
+  remove() {
+    const siblings = this.parentNode?.childNodes;
+    if (siblings) siblings.splice(siblings.indexOf(this), 1);
+    this.parentNode = null;
+  }
+}
+
+class Text extends Node {
+  nodeType = 3;
+
+  constructor(data) {
+    super();
+    this.data = data;
+  }
+
+  appendData(data) {
+    this.data += data;
+  }
+
+  get outerHTML() {
+    return escape(this.data);
+  }
+}
+
+class Comment extends Node {
+  nodeType = 8;
+
+  constructor(raw) {
+    super();
+    this.raw = raw;
+  }
+
+  get outerHTML() {
+    return this.raw;
+  }
+}
+
+class ParentNode extends Node {
+  childNodes = [];
+
+  get lastChild() {
+    return this.childNodes.at(-1) ?? null;
+  }
+
+  append(...nodes) {
+    for (const node of nodes) {
+      if (node instanceof Fragment) {
+        this.append(...node.childNodes);
+        continue;
+      }
+      node.remove();
+      node.parentNode = this;
+      this.childNodes.push(node);
+    }
+  }
+
+  get innerHTML() {
+    return this.childNodes.map((node) => node.outerHTML).join("");
+  }
+
+  set innerHTML(html) {
+    for (const node of [...this.childNodes]) node.remove();
+    const doc = this.ownerDocument;
+    const stack = [this];
+    for (const m of html.matchAll(TOKEN_RE)) {
+      const [token, closeTag, openTag, attrs] = m;
+      const parent = stack.at(-1);
+      if (token.startsWith("<!--")) {
+        parent.append(new Comment(token));
+      } else if (closeTag) {
+        const tag = closeTag.toLowerCase();
+        const i = stack.findLastIndex((el) => el.tagName === tag);
+        if (i > 0) stack.length = i;
+      } else if (openTag) {
+        const el = doc.createElement(openTag, attrs.replace(/\s*\/$/, ""));
+        parent.append(el);
+        if (!VOID_TAGS.has(el.tagName) && !attrs.endsWith("/")) stack.push(el);
+      } else {
+        parent.append(new Text(decode(token)));
+      }
+    }
+  }
+}
+
+class Fragment extends ParentNode {
+  nodeType = 11;
+}
+
+class Element extends ParentNode {
+  nodeType = 1;
+
+  constructor(doc, tag, attrs = "") {
+    super();
+    this.ownerDocument = doc;
+    this.tagName = tag.toLowerCase();
+    this.attrs = attrs;
+  }
+
+  get outerHTML() {
+    const open = `<${this.tagName}${this.attrs}>`;
+    if (VOID_TAGS.has(this.tagName)) return open;
+    return `${open}${this.innerHTML}</${this.tagName}>`;
+  }
+}
+
+class Template extends Element {
+  constructor(doc) {
+    super(doc, "template");
+    this.content = new Fragment();
+    this.content.ownerDocument = doc;
+  }
+
+  get innerHTML() {
+    return this.content.innerHTML;
+  }
+
+  set innerHTML(html) {
+    this.content.innerHTML = html;
+  }
+}
+
+class Document {
+  createElement(tag, attrs) {
+    return tag === "template"
+      ? new Template(this)
+      : new Element(this, tag, attrs);
+  }
+}
+
+export function createContainer() {
+  return new Document().createElement("div");
+}
+
+// innerHTML of a fresh container holding `html`.
+export function domHtml(html) {
+  const container = createContainer();
+  container.innerHTML = html;
+  return container.innerHTML;
+}
@@ -2,6 +2,7 @@ import { describe, it, expect } from "vitest";
 import { readFileSync } from "node:fs";
 import { fileURLToPath } from "node:url";
 import { dirname, join } from "node:path";
+import { createContainer, domHtml } from "./_dom.mjs";
 
 const __dirname = dirname(fileURLToPath(import.meta.url));
 const nitroIndex = readFileSync(
@@ -11,13 +12,18 @@ const nitroIndex = readFileSync(
 
 export function defineSuite({
   renderToHtml,
+  renderToHtmlBlocks,
+  renderToHtmlPatch,
+  applyHtmlPatch,
   renderToAST,
   renderToAnsi,
   parseAST,
   renderToMeta,
   parseMeta,
   renderToText,
+  renderToMarkdown,
   heal,
+  renderAll,
 }) {
   describe("renderToHtml", () => {
     it("renders a heading", async () => {
@@ -1412,6 +1418,18 @@ export function defineSuite({
       expect(meta.headings[0].text).toBe("Bold and italic heading");
     });
 
+    it("extracts headings around paragraphs, tables and lists", async () => {
+      const meta = await parseMeta(
+        "# Intro\n\nSome *text* with [a link][ref].\n\n| a | b |\n| - | - |\n| 1 | 2 |\n\n" +
+          "- item\n\n  ## Nested [ref] &amp; more\n\nSetext\n======\n\n[ref]: https://x.dev\n",
+      );
+      expect(meta.headings).toEqual([
+        { level: 1, text: "Intro" },
+        { level: 2, text: "Nested ref & more" },
+        { level: 1, text: "Setext" },
+      ]);
+    });
+
     it("handles frontmatter with complex YAML", async () => {
       const meta = await parseMeta(
         "---\ntitle: Hello\nauthor:\n  name: John\ntags:\n  - js\n  - ts\ncount: 42\ndraft: true\n---",
@@ -1423,6 +1441,44 @@ export function defineSuite({
       expect(meta.draft).toBe(true);
     });
 
+    it("handles flat frontmatter with lists, quotes and comments", async () => {
+      const meta = await parseMeta(
+        "---\n# comment\ntitle: \"Hello: World\"\nslug: 'a-b'\nempty:\n" +
+          "version: 1.5\npublished: no\ntags:\n- js\n- 42\n\nurl: https://x.dev/a?b=c\n---",
+      );
+      expect(meta.title).toBe("Hello: World");
+      expect(meta.slug).toBe("a-b");
+      expect(meta.empty).toBeNull();
+      expect(meta.version).toBe(1.5);
+      expect(meta.published).toBe(false);
+      expect(meta.tags).toEqual(["js", 42]);
+      expect(meta.url).toBe("https://x.dev/a?b=c");
+    });
+
+    it("reads comment lines like full YAML", async () => {
+      const cases = [
+        ["# c\u0085x: 1\na: 2", { x: 1, a: 2 }],
+        ["a: 1\n# c\u2028y: 2", { a: 1, y: 2 }],
+        ["a: 1\n# c\u2029y: 2", { a: 1, y: 2 }],
+        ["a: 1\n# c\ry: 2", { a: 1, y: 2 }],
+        ["a: 1\n# c\tok\nb: 2", { a: 1, b: 2 }],
+        ["a: 1\n# c\u0001\nb: 2", {}],
+      ];
+      for (const [yaml, props] of cases) {
+        const ast = await parseAST(`---\n${yaml}\n---\n\nx\n`);
+        expect(ast.frontmatter).toEqual(props);
+      }
+    });
+
+    it("falls back to full YAML for values it does not scan", async () => {
+      const meta = await parseMeta(
+        "---\ntitle: Hi # trailing comment\nquote: \"a\\tb\"\nlong: >\n  folded\n  text\n---",
+      );
+      expect(meta.title).toBe("Hi");
+      expect(meta.quote).toBe("a\tb");
+      expect(meta.long).toBe("folded text\n");
+    });
+
     it("handles frontmatter without title and heading", async () => {
       const meta = await parseMeta("---\ndraft: true\n---\n\nJust a paragraph");
       expect(meta.draft).toBe(true);
@@ -1704,6 +1760,334 @@ export function defineSuite({
     });
   });
 
+  describe("renderToHtmlBlocks", () => {
+    it("splits output at top-level blocks", async () => {
+      const input = "# Title\n\nSome *text*\n\n- a\n- b\n\n> quote";
+      const blocks = await renderToHtmlBlocks(input);
+      expect(blocks).toEqual([
+        "<h1>Title</h1>\n",
+        "<p>Some <em>text</em></p>\n",
+        "<ul>\n<li>a</li>\n<li>b</li>\n</ul>\n",
+        "<blockquote>\n<p>quote</p>\n</blockquote>\n",
+      ]);
+      expect(blocks.join("")).toBe(await renderToHtml(input));
+    });
+
+    it("returns no blocks for empty input", async () => {
+      expect(await renderToHtmlBlocks("")).toEqual([]);
+    });
+
+    it("skips frontmatter and keeps components whole", async () => {
+      const input =
+        "---\ntitle: x\n---\n::alert{a=1}\n---\nb: 2\n---\nhi\n::\n\npara";
+      expect(await renderToHtmlBlocks(input)).toEqual([
+        '<alert a="1" b="2">\n<p>hi</p>\n</alert>\n',
+        "<p>para</p>\n",
+      ]);
+    });
+
+    it("uses byte offsets correctly with multi-byte text", async () => {
+      const blocks = await renderToHtmlBlocks("# 日本語 🎉\n\nnäive");
+      expect(blocks).toEqual(["<h1>日本語 🎉</h1>\n", "<p>näive</p>\n"]);
+    });
+
+    it("supports heal option", async () => {
+      const blocks = await renderToHtmlBlocks("# Hello **world", {
+        heal: true,
+      });
+      expect(blocks).toEqual(["<h1>Hello <strong>world</strong></h1>\n"]);
+    });
+  });
+
+  describe("renderToHtmlPatch", () => {
+    it("appends blocks from an empty state", async () => {
+      const { ops, blocks } = await renderToHtmlPatch("# A\n\nb");
+      expect(ops).toEqual([
+        { type: "append", blocks: ["<h1>A</h1>\n", "<p>b</p>\n"] },
+      ]);
+      expect(blocks).toHaveLength(2);
+    });
+
+    it("emits no ops when nothing changed", async () => {
+      const { blocks } = await renderToHtmlPatch("# A");
+      expect((await renderToHtmlPatch("# A", blocks)).ops).toEqual([]);
+    });
+
+    it("appends text to the last text node", async () => {
+      const { blocks } = await renderToHtmlPatch("Some *em* te");
+      const { ops } = await renderToHtmlPatch("Some *em* text & more", blocks);
+      expect(ops).toEqual([
+        {
+          type: "text",
+          text: "xt & more",
+          block: "<p>Some <em>em</em> text &amp; more</p>\n",
+        },
+      ]);
+    });
+
+    it("replaces the last block when markup changes", async () => {
+      const { blocks } = await renderToHtmlPatch("# A\n\nSome");
+      const { ops } = await renderToHtmlPatch("# A\n\nSome *em*", blocks);
+      expect(ops).toEqual([
+        { type: "replace", count: 1, blocks: ["<p>Some <em>em</em></p>\n"] },
+      ]);
+    });
+
+    it("streams a document chunk by chunk", async () => {
+      const doc =
+        "# Title\n\nHello **world** and more\n\n```js\nconst a = 1;\n```\n";
+      let prev = [];
+      let dom = [];
+      for (let i = 1; i <= doc.length; i += 3) {
+        const { ops, blocks } = await renderToHtmlPatch(doc.slice(0, i), prev, {
+          heal: true,
+        });
+        for (const op of ops) {
+          if (op.type === "append") dom.push(...op.blocks);
+          else if (op.type === "replace") {
+            dom = [...dom.slice(0, dom.length - op.count), ...op.blocks];
+          } else dom[dom.length - 1] = op.block;
+        }
+        expect(dom).toEqual(blocks);
+        prev = blocks;
+      }
+    });
+  });
+
+  describe("applyHtmlPatch", () => {
+    async function patchTo(container, input, prev) {
+      const patch = await renderToHtmlPatch(input, prev);
+      applyHtmlPatch(container, patch.ops);
+      return patch;
+    }
+
+    it("appends blocks", async () => {
+      const container = createContainer();
+      const { blocks } = await patchTo(container, "# A");
+      const { ops } = await patchTo(container, "# A\n\nb\n\n- c", blocks);
+      expect(ops.map((op) => op.type)).toEqual(["append"]);
+      expect(container.innerHTML).toBe(
+        domHtml(await renderToHtml("# A\n\nb\n\n- c")),
+      );
+    });
+
+    it("replaces the last block", async () => {
+      const container = createContainer();
+      const { blocks } = await patchTo(container, "# A\n\nSome");
+      const { ops } = await patchTo(container, "# A\n\nSome *em*", blocks);
+      expect(ops.map((op) => op.type)).toEqual(["replace"]);
+      expect(container.innerHTML).toBe(
+        domHtml(await renderToHtml("# A\n\nSome *em*")),
+      );
+    });
+
+    it("removes blocks", async () => {
+      const container = createContainer();
+      const { blocks } = await patchTo(container, "# A\n\nb\n\n> c");
+      const { ops } = await patchTo(container, "# A", blocks);
+      expect(ops).toEqual([{ type: "replace", count: 2, blocks: [] }]);
+      expect(container.innerHTML).toBe(domHtml(await renderToHtml("# A")));
+    });
+
+    it("appends text to the last text node in place", async () => {
+      const container = createContainer();
+      const { blocks } = await patchTo(container, "# A\n\nSome *em* te");
+      const p = container.lastChild.previousSibling;
+      const textNode = p.lastChild;
+      const { ops } = await patchTo(
+        container,
+        "# A\n\nSome *em* text & 1 < 2",
+        blocks,
+      );
+      expect(ops.map((op) => op.type)).toEqual(["text"]);
+      expect(p.lastChild).toBe(textNode);
+      expect(container.innerHTML).toBe(
+        domHtml(await renderToHtml("# A\n\nSome *em* text & 1 < 2")),
+      );
+    });
+
+    it("matches a full render while streaming", async () => {
+      const doc =
+        "# Title\n\nHello **world** & more\n\n- a\n- b\n\n```js\nconst a = 1;\n```\n\n| x |\n|---|\n| 1 |\n";
+      const container = createContainer();
+      const seen = new Set();
+      let prev = [];
+      for (let i = 1; i <= doc.length; i += 2) {
+        const source = doc.slice(0, i);
+        const { ops, blocks } = await renderToHtmlPatch(source, prev, {
+          heal: true,
+        });
+        applyHtmlPatch(container, ops);
+        for (const op of ops) seen.add(op.type);
+        expect(container.innerHTML).toBe(
+          domHtml(await renderToHtml(source, { heal: true })),
+        );
+        prev = blocks;
+      }
+      expect([...seen].sort()).toEqual(["append", "replace", "text"]);
+    });
+  });
+
+  describe("renderAll", () => {
+    const doc =
+      "---\ntitle: Doc\n---\n# Hello\n\nSome **bold** text.\n\n::card{icon=x}\nBody\n::\n";
+
+    it("matches the individual renderers", async () => {
+      const out = await renderAll(doc, ["html", "ast", "meta", "text"]);
+      expect(out.html).toBe(await renderToHtml(doc));
+      expect(out.ast).toBe(await renderToAST(doc));
+      expect(out.meta).toBe(await renderToMeta(doc));
+      expect(out.text).toBe(await renderToText(doc));
+    });
+
+    it("matches the individual renderers on a large document", async () => {
+      const out = await renderAll(nitroIndex, ["html", "text"]);
+      expect(out.html).toBe(await renderToHtml(nitroIndex));
+      expect(out.text).toBe(await renderToText(nitroIndex));
+    });
+
+    it("returns only the requested formats", async () => {
+      const out = await renderAll("# Hi", ["text", "html"]);
+      expect(Object.keys(out).sort()).toEqual(["html", "text"]);
+      expect(await renderAll("# Hi", [])).toEqual({});
+    });
+
+    it("supports heal option", async () => {
+      const out = await renderAll("# Hello **world", ["html", "text"], {
+        heal: true,
+      });
+      expect(out.html).toBe("<h1>Hello <strong>world</strong></h1>\n");
+      expect(out.text).toBe(
+        await renderToText("# Hello **world", { heal: true }),
+      );
+    });
+
+    it("reports parser stats", async () => {
+      const input = "# Title\n\n- *a* [b]\n- c\n\n[b]: /url\n";
+      const out = await renderAll(input, ["html"], { stats: true });
+      expect(out.html).toBe(await renderToHtml(input));
+      expect(out.stats.lines).toBe(6);
+      expect(out.stats.blocks).toBe(3);
+      expect(out.stats.containers).toBe(3);
+      expect(out.stats.refDefs).toBe(1);
+      expect(out.stats.marks).toBeGreaterThan(0);
+      expect(out.stats.peakBlockBytes).toBeGreaterThan(0);
+      expect(Object.keys(out.stats.timings)).toEqual([
+        "blocks",
+        "refDefs",
+        "marks",
+        "resolve",
+        "emit",
+      ]);
+      for (const ms of Object.values(out.stats.timings)) {
+        expect(ms).toBeGreaterThanOrEqual(0);
+      }
+    });
+
+    it("reports parser stats without formats", async () => {
+      const out = await renderAll("a\n\nb", [], { stats: true });
+      expect(Object.keys(out)).toEqual(["stats"]);
+      expect(out.stats.blocks).toBe(2);
+    });
+
+    it("renders within limits", async () => {
+      const input = "> - *a* b\n\nc\n";
+      const out = await renderAll(input, ["html"], {
+        limits: { maxDepth: 2, maxBlocks: 5, maxMarks: 4, maxSteps: 13 },
+      });
+      expect(out.html).toBe(await renderToHtml(input));
+    });
+
+    it("throws when limits are exceeded", async () => {
+      const cases = [
+        ["> > > deep", { maxDepth: 2 }],
+        ["a\n\nb\n\nc", { maxBlocks: 2 }],
+        ["*a* *b* *c*", { maxMarks: 4 }],
+        ["a".repeat(100), { maxOutputBytes: 10 }],
+        ["a\nb\nc\nd\ne", { maxSteps: 3 }],
+      ];
+      for (const [input, limits] of cases) {
+        let error;
+        try {
+          await renderAll(input, ["html"], { limits });
+        } catch (err) {
+          error = err;
+        }
+        expect(error?.code).toBe("MD4X_LIMIT_EXCEEDED");
+      }
+    });
+
+    it("throws on unknown formats", async () => {
+      expect(() => renderAll("x", ["pdf"])).toThrow(TypeError);
+      expect(() => renderAll("x", ["pdf"])).toThrow(
+        'md4x: unsupported renderAll format "pdf"',
+      );
+    });
+  });
+
+  describe("limits option", () => {
+    const highlighter = () => undefined;
+    const entries = {
+      renderToHtml: (input, opts) => renderToHtml(input, opts),
+      "renderToHtml with highlighter": (input, opts) =>
+        renderToHtml(input, { ...opts, highlighter }),
+      renderToHtmlBlocks: (input, opts) => renderToHtmlBlocks(input, opts),
+      renderToHtmlPatch: (input, opts) => renderToHtmlPatch(input, [], opts),
+      renderToAST: (input, opts) => renderToAST(input, opts),
+      parseAST: (input, opts) => parseAST(input, opts),
+      renderToAnsi: (input, opts) => renderToAnsi(input, opts),
+      "renderToAnsi with highlighter": (input, opts) =>
+        renderToAnsi(input, { ...opts, highlighter }),
+      renderToMeta: (input, opts) => renderToMeta(input, opts),
+      parseMeta: (input, opts) => parseMeta(input, opts),
+      renderToText: (input, opts) => renderToText(input, opts),
+      renderToMarkdown: (input, opts) => renderToMarkdown(input, opts),
+      "renderAll ansi": (input, opts) => renderAll(input, ["ansi"], opts),
+      "renderAll markdown": (input, opts) =>
+        renderAll(input, ["markdown"], opts),
+    };
+
+    async function limitError(fn) {
+      try {
+        await fn();
+      } catch (err) {
+        return err;
+      }
+    }
+
+    for (const [name, render] of Object.entries(entries)) {
+      it(`${name} renders within limits`, async () => {
+        const input = "# a\n\n```js\nb\n```\n\n*c*";
+        expect(
+          await render(input, { limits: { maxBlocks: 3, maxMarks: 4 } }),
+        ).toEqual(await render(input));
+      });
+
+      it(`${name} throws when limits are exceeded`, async () => {
+        const cases = [
+          ["a\n\nb\n\nc", { maxBlocks: 2 }],
+          ["*a* *b* *c*", { maxMarks: 4 }],
+          ["> > > deep", { maxDepth: 2 }],
+        ];
+        for (const [input, limits] of cases) {
+          const error = await limitError(() => render(input, { limits }));
+          expect(error?.code).toBe("MD4X_LIMIT_EXCEEDED");
+        }
+      });
+    }
+
+    it("heal applies maxOutputBytes", async () => {
+      const input = "**" + "a".repeat(20);
+      expect(await heal(input, { limits: { maxOutputBytes: 100 } })).toBe(
+        await heal(input),
+      );
+      const error = await limitError(() =>
+        heal(input, { limits: { maxOutputBytes: 10 } }),
+      );
+      expect(error?.code).toBe("MD4X_LIMIT_EXCEEDED");
+    });
+  });
+
   describe("memory safety regressions", () => {
     // Regression: dynamic component named "pre" or "code" must NOT flatten
     // children into literal text. The AST renderer must check tag_is_dynamic
@@ -2,13 +2,18 @@ import { beforeAll, describe, it, expect } from "vitest";
 import {
   init,
   renderToHtml,
+  renderToHtmlBlocks,
+  renderToHtmlPatch,
+  applyHtmlPatch,
   renderToAST,
   renderToAnsi,
   parseAST,
   renderToMeta,
   parseMeta,
   renderToText,
+  renderToMarkdown,
   heal,
+  renderAll,
 } from "md4x/wasm";
 import { _setInstance, _getExports } from "../lib/wasm/common.mjs";
 import { defineSuite } from "./_suite.mjs";
@@ -19,13 +24,18 @@ beforeAll(async () => {
 
 defineSuite({
   renderToHtml,
+  renderToHtmlBlocks,
+  renderToHtmlPatch,
+  applyHtmlPatch,
   renderToAST,
   renderToAnsi,
   parseAST,
   renderToMeta,
   parseMeta,
   renderToText,
+  renderToMarkdown,
   heal,
+  renderAll,
 });
 
 describe("wasm: error handling", () => {
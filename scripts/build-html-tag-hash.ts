@@ -0,0 +1,81 @@
+// Generates the perfect hash table of the tag names which start raw HTML
+// blocks of type 1 and 6 (see md_lookup_html_block_tag() in src/md4x.c).
+//
+// A name hashes with FNV-1a over its lowercase characters. The hash picks one
+// of DISP_SIZE displacements, and (hash >> 8) plus the displacement, modulo
+// TABLE_SIZE, is the slot of the name.
+
+import { wrapLines } from "./_unicode-map.ts";
+
+const TABLE_SIZE = 128;
+const DISP_SIZE = 16;
+
+const tags: [string, number][] = [
+  ...["pre", "script", "style", "textarea"].map(
+    (t) => [t, 1] as [string, number],
+  ),
+  ...[
+    "address", "article", "aside", "base", "basefont", "blockquote", "body",
+    "caption", "center", "col", "colgroup", "dd", "details", "dialog", "dir",
+    "div", "dl", "dt", "fieldset", "figcaption", "figure", "footer", "form",
+    "frame", "frameset", "h1", "h2", "h3", "h4", "h5", "h6", "head", "header",
+    "hr", "html", "iframe", "legend", "li", "link", "main", "menu", "menuitem",
+    "nav", "noframes", "ol", "optgroup", "option", "p", "param", "search",
+    "section", "summary", "table", "tbody", "td", "tfoot", "th", "thead",
+    "title", "tr", "track", "ul",
+  ].map((t) => [t, 6] as [string, number]),
+];
+
+function hash(name: string): number {
+  let h = 2166136261;
+  for (let i = 0; i < name.length; i++)
+    h = Math.imul(h ^ name.charCodeAt(i), 16777619) >>> 0;
+  return h;
+}
+
+// Place the buckets sharing a displacement, largest first.
+const buckets = new Map<number, [string, number][]>();
+for (const tag of tags) {
+  const b = hash(tag[0]) % DISP_SIZE;
+  buckets.set(b, [...(buckets.get(b) ?? []), tag]);
+}
+
+const disp: number[] = new Array(DISP_SIZE).fill(0);
+const table: ([string, number] | null)[] = new Array(TABLE_SIZE).fill(null);
+const order = [...buckets.keys()].sort(
+  (a, b) => buckets.get(b)!.length - buckets.get(a)!.length || a - b,
+);
+for (const b of order) {
+  const list = buckets.get(b)!;
+  let d = 0;
+  for (; d < 256; d++) {
+    const slots = list.map((t) => ((hash(t[0]) >>> 8) + d) % TABLE_SIZE);
+    if (
+      new Set(slots).size === slots.length &&
+      slots.every((s) => table[s] === null)
+    ) {
+      slots.forEach((s, i) => (table[s] = list[i]));
+      break;
+    }
+  }
+  if (d === 256) throw new Error("no perfect hash, grow TABLE_SIZE");
+  disp[b] = d;
+}
+
+const maxLen = Math.max(...tags.map((t) => t[0].length));
+
+process.stdout.write(`#define HTML_TAG_MAXLEN     ${maxLen}\n`);
+process.stdout.write(`#define HTML_TAG_DISP_SIZE  ${DISP_SIZE}\n`);
+process.stdout.write(`#define HTML_TAG_TABLE_SIZE ${TABLE_SIZE}\n\n`);
+process.stdout.write(`static const unsigned char HTML_TAG_DISP[HTML_TAG_DISP_SIZE] = {\n`);
+process.stdout.write(wrapLines(disp.join(", "), 80, "    "));
+process.stdout.write("\n};\n\n");
+process.stdout.write(`static const TAG HTML_TAG_TABLE[HTML_TAG_TABLE_SIZE] = {\n`);
+// Wrap between the entries only (U+00A0 keeps each entry on one line).
+const entries = table.map((t) =>
+  t ? `X("${t[0]}",\u00a0${t[1]})` : "Xnone",
+);
+process.stdout.write(
+  wrapLines(entries.join(", "), 80, "    ").replace(/\u00a0/g, " "),
+);
+process.stdout.write("\n};\n");
@@ -126,9 +126,12 @@ cmdline_read(const CMDLINE_OPTION* options, int argc, char** argv,
                     if(strncmp(argv[i]+2, opt->longname, len) == 0) {
                         /* Regular long option. */
                         if(argv[i][2+len] == '\0') {
-                            /* with no argument provided. */
+                            /* with no argument provided, or with the
+                             * required argument in the next token. */
                             if(!(opt->flags & CMDLINE_OPTFLAG_REQUIREDARG))
                                 ret = callback(opt->id, NULL, userdata);
+                            else if(i+1 < argc)
+                                ret = callback(opt->id, argv[++i], userdata);
                             else
                                 ret = callback(CMDLINE_OPTID_MISSINGARG, argv[i], userdata);
                             break;
@@ -35,7 +35,8 @@ extern "C" {
 #define CMDLINE_OPTFLAG_OPTIONALARG     0x0001
 
 /* The option must have an argument.
- * Such short option cannot be grouped within single '-abc'. */
+ * Such short option cannot be grouped within single '-abc'.
+ * Long option accepts both '--opt=arg' and '--opt arg'. */
 #define CMDLINE_OPTFLAG_REQUIREDARG     0x0002
 
 /* Enable special compiler-like mode for the long option.
@@ -28,12 +28,31 @@
 #include <string.h>
 #include <time.h>
 
+#ifndef _WIN32
+    #define MD4X_CLI_POSIX 1
+    #include <dirent.h>
+    #include <errno.h>
+    #include <glob.h>
+    #include <pthread.h>
+    #include <signal.h>
+    #include <sys/mman.h>
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#else
+    #include <fcntl.h>
+    #include <io.h>
+#endif
+
 #include "md4x-html.h"
 #include "md4x-ast.h"
 #include "md4x-ansi.h"
 #include "md4x-text.h"
 #include "md4x-markdown.h"
 #include "md4x-heal.h"
+#include "md4x-multi.h"
+#include "md4x-trace.h"
 #include "cmdline.h"
 
 
@@ -49,6 +68,7 @@ typedef enum {
 } OutputFormat;
 
 static const char* format_name[] = { "html", "text", "json", "ansi", "markdown", "heal" };
+static const char* format_ext[] = { ".html", ".txt", ".json", ".ansi", ".md", ".md" };
 
 /* Global options. */
 static OutputFormat output_format = FORMAT_HTML;
@@ -62,19 +82,52 @@ static int want_fullhtml = 0;
 static int want_heal = 0;
 static int want_stat = 0;
 static int want_replay_fuzz = 0;
+static int want_batch = 0;
+static int batch_jobs = 0;
+static const char* out_dir = NULL;
+static int want_serve = 0;
+static const char* socket_path = NULL;
+static int bench_runs = 0;
+static int want_bench_all = 0;
+static int want_bench_json = 0;
+static const char* trace_path = NULL;
 
 static const char* html_title = NULL;
 static const char* css_path = NULL;
 
+/* Settings of rendering a single document. The command line options set
+ * them for all inputs; in server mode each request carries its own. */
+typedef struct {
+    OutputFormat format;
+    unsigned p_flags;
+    unsigned r_flags;
+    int heal;
+    int fullhtml;
+    const char* html_title;
+    const char* css_url;
+} RENDER_OPTS;
+
+static void
+render_opts_init(RENDER_OPTS* opts)
+{
+    opts->format = output_format;
+    opts->p_flags = parser_flags;
+    opts->r_flags = renderer_flags;
+    opts->heal = want_heal;
+    opts->fullhtml = want_fullhtml;
+    opts->html_title = html_title;
+    opts->css_url = css_path;
+}
+
 
 /*********************************
  ***  Simple grow-able buffer  ***
  *********************************/
 
-/* We render to a memory buffer instead of directly outputting the rendered
- * documents, as this allows using this utility for evaluating performance
- * of MD4X (--stat option). This allows us to measure just time of the parser,
- * without the I/O.
+/* With --stat, we render to a memory buffer instead of directly outputting
+ * the rendered documents, as this allows using this utility for evaluating
+ * performance of MD4X. This allows us to measure just time of the parser,
+ * without the I/O. (Otherwise see struct fdbuffer below.)
  */
 
 struct membuffer {
@@ -84,7 +137,7 @@ struct membuffer {
 };
 
 static void
-membuf_init(struct membuffer* buf, MD_SIZE new_asize)
+membuf_init(struct membuffer* buf, size_t new_asize)
 {
     buf->size = 0;
     buf->asize = new_asize;
@@ -114,7 +167,7 @@ membuf_grow(struct membuffer* buf, size_t new_asize)
 }
 
 static void
-membuf_append(struct membuffer* buf, const char* data, MD_SIZE size)
+membuf_append(struct membuffer* buf, const char* data, size_t size)
 {
     if(buf->asize < buf->size + size)
         membuf_grow(buf, buf->size + buf->size / 2 + size);
@@ -122,90 +175,206 @@ membuf_append(struct membuffer* buf, const char* data, MD_SIZE size)
     buf->size += size;
 }
 
+/* Append the whole contents of the stream to the buffer. */
+static int
+membuf_read(struct membuffer* buf, FILE* in)
+{
+    size_t n;
 
-/**********************
- ***  Main program  ***
- **********************/
+    while(1) {
+        if(buf->size >= buf->asize)
+            membuf_grow(buf, buf->asize + buf->asize / 2);
+
+        n = fread(buf->data + buf->size, 1, buf->asize - buf->size, in);
+        if(n == 0)
+            break;
+        buf->size += n;
+    }
+
+    return ferror(in) ? -1 : 0;
+}
+
+
+/********************************
+ ***  Streaming output buffer ***
+ ********************************/
+
+/* Fixed-size buffer flushed to the output file whenever it fills up, so the
+ * rendered document never has to be held in memory as a whole.
+ */
+
+#define FDBUF_SIZE      (64 * 1024)
+
+struct fdbuffer {
+    FILE* out;
+    size_t size;
+    int error;
+    char data[FDBUF_SIZE];
+};
 
 static void
-process_output(const MD_CHAR* text, MD_SIZE size, void* userdata)
+fdbuf_write(struct fdbuffer* buf, const char* data, size_t size)
 {
-    membuf_append((struct membuffer*) userdata, text, size);
+#ifdef MD4X_CLI_POSIX
+    int fd = fileno(buf->out);
+
+    while(size > 0  &&  !buf->error) {
+        ssize_t n = write(fd, data, size);
+        if(n < 0) {
+            if(errno == EINTR)
+                continue;
+            buf->error = 1;
+            break;
+        }
+        data += n;
+        size -= (size_t) n;
+    }
+#else
+    if(fwrite(data, 1, size, buf->out) != size)
+        buf->error = 1;
+#endif
+}
+
+static void
+fdbuf_flush(struct fdbuffer* buf)
+{
+    fdbuf_write(buf, buf->data, buf->size);
+    buf->size = 0;
+}
+
+static void
+fdbuf_append(struct fdbuffer* buf, const char* data, size_t size)
+{
+    if(buf->size + size > FDBUF_SIZE) {
+        fdbuf_flush(buf);
+        /* Large chunks bypass the buffer. */
+        if(size >= FDBUF_SIZE) {
+            fdbuf_write(buf, data, size);
+            return;
+        }
+    }
+    memcpy(buf->data + buf->size, data, size);
+    buf->size += size;
 }
 
+
+/*************************
+ ***  Input mapping    ***
+ *************************/
+
+/* Regular files are mapped into memory instead of being copied into a
+ * buffer; pipes and other streams are read with membuf_read().
+ */
+
+struct input {
+    const char* data;
+    size_t size;
+    struct membuffer buf;
+    size_t map_size;    /* Non-zero if data is mapped. */
+};
+
 static int
-process_file(const char* in_path, FILE* in, FILE* out)
+input_open(struct input* input, FILE* in, int writable)
 {
-    size_t n;
-    struct membuffer buf_in = {0};
-    struct membuffer buf_out = {0};
-    int ret = -1;
-    clock_t t0, t1;
-    unsigned p_flags = parser_flags;
-    unsigned r_flags = renderer_flags;
+    memset(input, 0, sizeof(struct input));
 
-    membuf_init(&buf_in, 32 * 1024);
+#ifdef MD4X_CLI_POSIX
+    {
+        struct stat st;
+        int fd = fileno(in);
 
-    /* Read the input file into a buffer. */
-    while(1) {
-        if(buf_in.size >= buf_in.asize)
-            membuf_grow(&buf_in, buf_in.asize + buf_in.asize / 2);
+        if(fstat(fd, &st) == 0  &&  S_ISREG(st.st_mode)  &&  st.st_size > 0  &&
+           (unsigned long long) st.st_size <= (size_t) -1)
+        {
+            void* addr = mmap(NULL, (size_t) st.st_size,
+                        writable ? (PROT_READ | PROT_WRITE) : PROT_READ,
+                        MAP_PRIVATE, fd, 0);
+            if(addr != MAP_FAILED) {
+                input->data = (const char*) addr;
+                input->size = (size_t) st.st_size;
+                input->map_size = input->size;
+                return 0;
+            }
+        }
+    }
+#else
+    (void) writable;
+#endif
 
-        n = fread(buf_in.data + buf_in.size, 1, buf_in.asize - buf_in.size, in);
-        if(n == 0)
-            break;
-        buf_in.size += n;
+    membuf_init(&input->buf, 32 * 1024);
+    if(membuf_read(&input->buf, in) != 0)
+        return -1;
+    input->data = input->buf.data;
+    input->size = input->buf.size;
+    return 0;
+}
+
+static void
+input_close(struct input* input)
+{
+#ifdef MD4X_CLI_POSIX
+    if(input->map_size > 0) {
+        munmap((void*) input->data, input->map_size);
+        return;
     }
+#endif
+    membuf_fini(&input->buf);
+}
 
-    /* Input size is good estimation of output size. Add some more reserve to
-     * deal with the HTML header/footer and tags. */
-    membuf_init(&buf_out, (MD_SIZE)(buf_in.size + buf_in.size/8 + 64));
 
-    /* Special mode for reproduce test case found with fuzzing a tool.
-     * We assume file format as produced by test/fuzzers/fuzz-mdhtml.c. */
-    if(want_replay_fuzz) {
-        if(buf_in.size < 2 * sizeof(unsigned)) {
-            fprintf(stderr, "File %s isn't valid fuzz test case.\n", in_path);
-            ret = -1;
-            goto out;
-        }
+/**********************
+ ***  Main program  ***
+ **********************/
 
-        /* Override parser and renderer flags with those from the test case. */
-        memcpy(&p_flags, buf_in.data, sizeof(unsigned));
-        memcpy(&r_flags, buf_in.data + sizeof(unsigned), sizeof(unsigned));
+static void
+process_output(const MD_CHAR* text, MD_SIZE size, void* userdata)
+{
+    membuf_append((struct membuffer*) userdata, text, size);
+}
 
-        /* And get rid of them from the text input to the parser. */
-        memmove(buf_in.data, buf_in.data + 2 * sizeof(unsigned),
-                    buf_in.size - 2 * sizeof(unsigned));
-        buf_in.size -= 2 * sizeof(unsigned);
+static void
+process_output_fd(const MD_CHAR* text, MD_SIZE size, void* userdata)
+{
+    fdbuf_append((struct fdbuffer*) userdata, text, size);
+}
 
-        /* Zero the tail we have moved the contents from.
-         * It helps in debugging if make it actually a zero-terminated string. */
-        memset(buf_in.data + buf_in.size, 0, 2 * sizeof(unsigned));
+/* Render the document in the selected output format. */
+static int
+render_document(const char* data, size_t size,
+                void (*output)(const MD_CHAR*, MD_SIZE, void*), void* userdata,
+                const RENDER_OPTS* opts)
+{
+    unsigned p_flags = opts->p_flags;
+    unsigned r_flags = opts->r_flags;
+    int ret = -1;
+
+#ifndef MD4X_WIDE_OFFSETS
+    /* Larger documents need the 64-bit MD_SIZE of MD4X_WIDE_OFFSETS. */
+    if(size > (MD_SIZE) -1) {
+        fprintf(stderr, "Input larger than 4 GiB (build with -Dwide-offsets).\n");
+        return -1;
     }
+#endif
 
     /* Apply heal flag to renderer flags if requested (HTML uses r_flags). */
-    if(want_heal)
+    if(opts->heal)
         r_flags |= MD_HTML_FLAG_HEAL;
 
-    /* Parse and render the document. */
-    t0 = clock();
-
-    switch(output_format) {
+    switch(opts->format) {
         case FORMAT_HTML: {
             unsigned html_flags = r_flags;
             MD_HTML_OPTS html_opts = { NULL, NULL };
             const MD_HTML_OPTS* opts_ptr = NULL;
 
-            if(want_fullhtml) {
+            if(opts->fullhtml) {
                 html_flags |= MD_HTML_FLAG_FULL_HTML;
-                html_opts.title = html_title;
-                html_opts.css_url = css_path;
+                html_opts.title = opts->html_title;
+                html_opts.css_url = opts->css_url;
                 opts_ptr = &html_opts;
             }
 
-            ret = md_html_ex(buf_in.data, (MD_SIZE)buf_in.size, process_output,
-                        (void*) &buf_out, p_flags, html_flags, opts_ptr);
+            ret = md_html_ex(data, (MD_SIZE)size, output,
+                        userdata, p_flags, html_flags, opts_ptr);
             break;
         }
         case FORMAT_JSON: {
@@ -213,9 +382,9 @@ process_file(const char* in_path, FILE* in, FILE* out)
 #ifndef MD4X_USE_ASCII
             j_flags |= MD_AST_FLAG_SKIP_UTF8_BOM;
 #endif
-            if(want_heal) j_flags |= MD_AST_FLAG_HEAL;
-            ret = md_ast(buf_in.data, (MD_SIZE)buf_in.size, process_output,
-                        (void*) &buf_out, p_flags, j_flags);
+            if(opts->heal) j_flags |= MD_AST_FLAG_HEAL;
+            ret = md_ast(data, (MD_SIZE)size, output,
+                        userdata, p_flags, j_flags);
             break;
         }
         case FORMAT_ANSI: {
@@ -223,9 +392,9 @@ process_file(const char* in_path, FILE* in, FILE* out)
 #ifndef MD4X_USE_ASCII
             a_flags |= MD_ANSI_FLAG_SKIP_UTF8_BOM;
 #endif
-            if(want_heal) a_flags |= MD_ANSI_FLAG_HEAL;
-            ret = md_ansi(buf_in.data, (MD_SIZE)buf_in.size, process_output,
-                        (void*) &buf_out, p_flags, a_flags);
+            if(opts->heal) a_flags |= MD_ANSI_FLAG_HEAL;
+            ret = md_ansi(data, (MD_SIZE)size, output,
+                        userdata, p_flags, a_flags);
             break;
         }
         case FORMAT_TEXT: {
@@ -233,9 +402,9 @@ process_file(const char* in_path, FILE* in, FILE* out)
 #ifndef MD4X_USE_ASCII
             t_flags |= MD_TEXT_FLAG_SKIP_UTF8_BOM;
 #endif
-            if(want_heal) t_flags |= MD_TEXT_FLAG_HEAL;
-            ret = md_text(buf_in.data, (MD_SIZE)buf_in.size, process_output,
-                        (void*) &buf_out, p_flags, t_flags);
+            if(opts->heal) t_flags |= MD_TEXT_FLAG_HEAL;
+            ret = md_text(data, (MD_SIZE)size, output,
+                        userdata, p_flags, t_flags);
             break;
         }
         case FORMAT_MARKDOWN: {
@@ -243,27 +412,152 @@ process_file(const char* in_path, FILE* in, FILE* out)
 #ifndef MD4X_USE_ASCII
             pm_flags |= MD_MARKDOWN_FLAG_SKIP_UTF8_BOM;
 #endif
-            if(want_heal) pm_flags |= MD_MARKDOWN_FLAG_HEAL;
-            ret = md_markdown(buf_in.data, (MD_SIZE)buf_in.size, process_output,
-                        (void*) &buf_out, p_flags, pm_flags);
+            if(opts->heal) pm_flags |= MD_MARKDOWN_FLAG_HEAL;
+            ret = md_markdown(data, (MD_SIZE)size, output,
+                        userdata, p_flags, pm_flags);
             break;
         }
         case FORMAT_HEAL: {
-            ret = md_heal(buf_in.data, (MD_SIZE)buf_in.size, process_output,
-                        (void*) &buf_out);
+            ret = md_heal(data, (MD_SIZE)size, output, userdata);
             break;
         }
     }
 
-    t1 = clock();
-    if(ret != 0) {
-        fprintf(stderr, "Parsing failed.\n");
-        goto out;
+    return ret;
+}
+
+static void
+discard_output(const MD_CHAR* text, MD_SIZE size, void* userdata)
+{
+    (void) text;
+    (void) size;
+    (void) userdata;
+}
+
+static void
+print_size(const char* label, size_t size)
+{
+    if(size < 1024)
+        fprintf(stderr, "  %-22s %9lu B\n", label, (unsigned long) size);
+    else
+        fprintf(stderr, "  %-22s %9.1f KiB\n", label, size / 1024.0);
+}
+
+/* For --stat: parse the document once more with md_parse_ex() and print
+ * where the time and memory went. HTML, JSON and text output is rendered
+ * again (and discarded) so the emit phase includes the renderer; other
+ * formats are only parsed. */
+static void
+print_parse_stats(const char* data, size_t size, const RENDER_OPTS* opts)
+{
+    MD_PARSE_STATS stats;
+    MD_RENDER_TARGET target;
+    unsigned flags = 0;
+    int n_targets = 1;
+
+    target.renderer_flags = 0;
+    target.process_output = discard_output;
+    target.userdata = NULL;
+    switch(opts->format) {
+        case FORMAT_HTML:   target.format = MD_RENDER_HTML; target.renderer_flags = opts->r_flags; break;
+        case FORMAT_JSON:   target.format = MD_RENDER_AST; break;
+        case FORMAT_TEXT:   target.format = MD_RENDER_TEXT; break;
+        default:            n_targets = 0; break;
+    }
+    if(opts->heal)
+        flags |= MD_MULTI_FLAG_HEAL;
+#ifndef MD4X_USE_ASCII
+    flags |= MD_MULTI_FLAG_SKIP_UTF8_BOM;
+#endif
+
+    if(md_render_multi(data, (MD_SIZE) size, &target, n_targets,
+                       opts->p_flags, flags, NULL, &stats) != 0)
+        return;
+
+    fprintf(stderr, "Parser statistics:\n");
+    fprintf(stderr, "  %-22s %9u\n", "lines", stats.n_lines);
+    fprintf(stderr, "  %-22s %9u\n", "leaf blocks", stats.n_blocks);
+    fprintf(stderr, "  %-22s %9u\n", "container blocks", stats.n_containers);
+    fprintf(stderr, "  %-22s %9u\n", "inline blocks", stats.n_inline_blocks);
+    fprintf(stderr, "  %-22s %9u (%.1f%%)\n", "  plain (no marks)", stats.n_plain_blocks,
+            stats.n_inline_blocks > 0 ? 100.0 * stats.n_plain_blocks / stats.n_inline_blocks : 0.0);
+    fprintf(stderr, "  %-22s %9u\n", "inline marks", stats.n_marks);
+    fprintf(stderr, "  %-22s %9u\n", "mark rollbacks", stats.n_rollbacks);
+    fprintf(stderr, "  %-22s %9u\n", "ref. definitions", stats.n_ref_defs);
+    fprintf(stderr, "  %-22s %9u\n", "buffer reallocations", stats.n_reallocs);
+    print_size("block buffer", stats.peak_block_bytes);
+    print_size("container buffer", stats.peak_container_bytes);
+    print_size("mark buffer", stats.peak_mark_bytes);
+    print_size("temporary buffer", stats.peak_buffer_bytes);
+    fprintf(stderr, "  %-22s %9.2f ms\n", "block analysis", stats.block_ns / 1e6);
+    fprintf(stderr, "  %-22s %9.2f ms\n", "ref. definition table", stats.ref_def_ns / 1e6);
+    fprintf(stderr, "  %-22s %9.2f ms\n", "mark collection", stats.mark_ns / 1e6);
+    fprintf(stderr, "  %-22s %9.2f ms\n", "mark resolution", stats.resolve_ns / 1e6);
+    fprintf(stderr, "  %-22s %9.2f ms\n", n_targets > 0 ? "emit (with renderer)" : "emit",
+            stats.emit_ns / 1e6);
+}
+
+static int
+process_file(const char* in_path, FILE* in, FILE* out)
+{
+    struct input input;
+    struct membuffer buf_out = {0};
+    struct fdbuffer* fdbuf = NULL;
+    RENDER_OPTS opts;
+    int ret = -1;
+    clock_t t0, t1;
+
+    render_opts_init(&opts);
+
+    /* Map or read the input file. (Replaying a fuzz test case rewrites it.) */
+    if(input_open(&input, in, want_replay_fuzz) != 0) {
+        fprintf(stderr, "Cannot read %s.\n", in_path);
+        input_close(&input);
+        return -1;
     }
 
-    fwrite(buf_out.data, 1, buf_out.size, out);
+    /* Special mode for reproduce test case found with fuzzing a tool.
+     * We assume file format as produced by test/fuzzers/fuzz-mdhtml.c. */
+    if(want_replay_fuzz) {
+        char* data = (char*) input.data;
+
+        if(input.size < 2 * sizeof(unsigned)) {
+            fprintf(stderr, "File %s isn't valid fuzz test case.\n", in_path);
+            ret = -1;
+            goto out;
+        }
+
+        /* Override parser and renderer flags with those from the test case. */
+        memcpy(&opts.p_flags, data, sizeof(unsigned));
+        memcpy(&opts.r_flags, data + sizeof(unsigned), sizeof(unsigned));
+
+        /* And get rid of them from the text input to the parser. */
+        memmove(data, data + 2 * sizeof(unsigned),
+                    input.size - 2 * sizeof(unsigned));
+        input.size -= 2 * sizeof(unsigned);
+
+        /* Zero the tail we have moved the contents from.
+         * It helps in debugging if make it actually a zero-terminated string. */
+        memset(data + input.size, 0, 2 * sizeof(unsigned));
+    }
 
     if(want_stat) {
+        /* Input size is good estimation of output size. Add some more reserve
+         * to deal with the HTML header/footer and tags. */
+        membuf_init(&buf_out, input.size + input.size/8 + 64);
+
+        /* Parse and render the document. */
+        t0 = clock();
+        ret = render_document(input.data, input.size, process_output,
+                    (void*) &buf_out, &opts);
+        t1 = clock();
+        if(ret != 0) {
+            fprintf(stderr, "Parsing failed.\n");
+            goto out;
+        }
+
+        fwrite(buf_out.data, 1, buf_out.size, out);
+
         if(t0 != (clock_t)-1  &&  t1 != (clock_t)-1) {
             double elapsed = (double)(t1 - t0) / CLOCKS_PER_SEC;
             if (elapsed < 1)
@@ -271,18 +565,889 @@ process_file(const char* in_path, FILE* in, FILE* out)
             else
                 fprintf(stderr, "Time spent on parsing: %6.3f s.\n", elapsed);
         }
+
+        print_parse_stats(input.data, input.size, &opts);
+    } else {
+        /* Stream the output as it is produced. */
+        fdbuf = malloc(sizeof(struct fdbuffer));
+        if(fdbuf == NULL) {
+            fprintf(stderr, "process_file: malloc() failed.\n");
+            exit(1);
+        }
+        fdbuf->out = out;
+        fdbuf->size = 0;
+        fdbuf->error = 0;
+        fflush(out);
+
+        ret = render_document(input.data, input.size, process_output_fd,
+                    (void*) fdbuf, &opts);
+        fdbuf_flush(fdbuf);
+        if(ret != 0) {
+            fprintf(stderr, "Parsing failed.\n");
+            goto out;
+        }
+        if(fdbuf->error) {
+            fprintf(stderr, "Cannot write output.\n");
+            ret = -1;
+            goto out;
+        }
     }
 
     /* Success if we have reached here. */
     ret = 0;
 
 out:
-    membuf_fini(&buf_in);
+    input_close(&input);
+    if(want_stat)
+        membuf_fini(&buf_out);
+    free(fdbuf);
+
+    return ret;
+}
+
+
+#ifdef MD4X_CLI_POSIX
+
+/********************
+ ***  Batch mode  ***
+ ********************/
+
+/* With --batch, every positional argument names a directory (walked
+ * recursively for *.md and *.markdown), a glob pattern or an @filelist.
+ * The files are spread over a pool of worker threads, each reusing its own
+ * input and output buffers, and the output is written under --out-dir
+ * mirroring the input tree.
+ */
+
+typedef struct {
+    char* path;         /* Path of the input file. */
+    size_t rel_off;     /* Start of the part of path mirrored under --out-dir. */
+} BATCH_FILE;
+
+typedef struct {
+    pthread_t thread;
+    struct membuffer buf_in;
+    struct membuffer buf_out;
+    size_t n_files;
+    size_t n_failed;
+    size_t in_bytes;
+    size_t out_bytes;
+} BATCH_WORKER;
+
+static BATCH_FILE* batch_files = NULL;
+static size_t batch_n_files = 0;
+static size_t batch_alloc_files = 0;
+static size_t batch_n_rejected = 0;
+
+static RENDER_OPTS batch_opts;
+static size_t batch_next_file = 0;
+static pthread_mutex_t batch_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static int
+batch_has_md_ext(const char* path)
+{
+    const char* ext = strrchr(path, '.');
+
+    if(ext == NULL  ||  strchr(ext, '/') != NULL)
+        return 0;
+    return (strcmp(ext, ".md") == 0  ||  strcmp(ext, ".markdown") == 0);
+}
+
+static void
+batch_add_file(const char* path, size_t rel_off)
+{
+    const char* rel;
+    const char* p;
+
+    /* Never let the mirrored path escape from --out-dir. */
+    while(path[rel_off] == '/')
+        rel_off++;
+    while(path[rel_off] == '.'  &&  path[rel_off+1] == '/') {
+        rel_off += 2;
+        while(path[rel_off] == '/')
+            rel_off++;
+    }
+    rel = path + rel_off;
+    for(p = rel; p != NULL; p = strchr(p, '/')) {
+        if(*p == '/')
+            p++;
+        if(p[0] == '.'  &&  p[1] == '.'  &&  (p[2] == '/'  ||  p[2] == '\0')) {
+            fprintf(stderr, "Skipping %s: path leads outside of the output directory.\n", path);
+            batch_n_rejected++;
+            return;
+        }
+    }
+    if(*rel == '\0') {
+        fprintf(stderr, "Skipping %s: not a file.\n", path);
+        batch_n_rejected++;
+        return;
+    }
+
+    if(batch_n_files >= batch_alloc_files) {
+        batch_alloc_files = (batch_alloc_files > 0) ? batch_alloc_files * 2 : 256;
+        batch_files = realloc(batch_files, batch_alloc_files * sizeof(BATCH_FILE));
+        if(batch_files == NULL) {
+            fprintf(stderr, "batch_add_file: realloc() failed.\n");
+            exit(1);
+        }
+    }
+
+    batch_files[batch_n_files].path = strdup(path);
+    if(batch_files[batch_n_files].path == NULL) {
+        fprintf(stderr, "batch_add_file: strdup() failed.\n");
+        exit(1);
+    }
+    batch_files[batch_n_files].rel_off = rel_off;
+    batch_n_files++;
+}
+
+static void
+batch_walk_dir(const char* dir_path, size_t root_len)
+{
+    DIR* dir;
+    struct dirent* ent;
+    struct stat st;
+    char* path;
+    size_t dir_len = strlen(dir_path);
+
+    dir = opendir(dir_path);
+    if(dir == NULL) {
+        fprintf(stderr, "Cannot open directory %s.\n", dir_path);
+        batch_n_rejected++;
+        return;
+    }
+
+    while((ent = readdir(dir)) != NULL) {
+        /* Skip ".", ".." and hidden files. */
+        if(ent->d_name[0] == '.')
+            continue;
+
+        path = malloc(dir_len + 1 + strlen(ent->d_name) + 1);
+        if(path == NULL) {
+            fprintf(stderr, "batch_walk_dir: malloc() failed.\n");
+            exit(1);
+        }
+        sprintf(path, "%s/%s", dir_path, ent->d_name);
+
+        if(lstat(path, &st) == 0) {
+            if(S_ISDIR(st.st_mode))
+                batch_walk_dir(path, root_len);
+            else if(S_ISREG(st.st_mode)  &&  batch_has_md_ext(path))
+                batch_add_file(path, root_len);
+        }
+        free(path);
+    }
+
+    closedir(dir);
+}
+
+static void
+batch_read_filelist(const char* list_path)
+{
+    FILE* list;
+    struct membuffer buf = {0};
+    char* line;
+    char* end;
+
+    if(strcmp(list_path, "-") == 0) {
+        list = stdin;
+    } else {
+        list = fopen(list_path, "rb");
+        if(list == NULL) {
+            fprintf(stderr, "Cannot open %s.\n", list_path);
+            exit(1);
+        }
+    }
+
+    membuf_init(&buf, 4 * 1024);
+    membuf_read(&buf, list);
+    membuf_append(&buf, "\n", 1);
+    if(list != stdin)
+        fclose(list);
+
+    /* One path per line; empty lines are ignored. */
+    for(line = buf.data; line < buf.data + buf.size; line = end + 1) {
+        end = memchr(line, '\n', buf.data + buf.size - line);
+        *end = '\0';
+        if(end > line  &&  end[-1] == '\r')
+            end[-1] = '\0';
+        if(*line != '\0')
+            batch_add_file(line, 0);
+    }
+
+    membuf_fini(&buf);
+}
+
+static void
+batch_add_input(const char* spec)
+{
+    struct stat st;
+
+    if(spec[0] == '@') {
+        batch_read_filelist(spec + 1);
+    } else if(strpbrk(spec, "*?[") != NULL) {
+        glob_t g;
+        const char* wild = strpbrk(spec, "*?[");
+        size_t prefix_len = 0;
+        size_t i;
+
+        /* Mirror the paths relative to the last directory before the first
+         * wildcard. */
+        for(i = 0; spec + i < wild; i++) {
+            if(spec[i] == '/')
+                prefix_len = i + 1;
+        }
+
+        if(glob(spec, 0, NULL, &g) != 0) {
+            fprintf(stderr, "No files match %s.\n", spec);
+            batch_n_rejected++;
+            return;
+        }
+        for(i = 0; i < g.gl_pathc; i++) {
+            if(stat(g.gl_pathv[i], &st) == 0  &&  S_ISREG(st.st_mode))
+                batch_add_file(g.gl_pathv[i], prefix_len);
+        }
+        globfree(&g);
+    } else if(stat(spec, &st) == 0  &&  S_ISDIR(st.st_mode)) {
+        batch_walk_dir(spec, strlen(spec));
+    } else if(stat(spec, &st) == 0) {
+        batch_add_file(spec, 0);
+    } else {
+        fprintf(stderr, "Cannot open %s.\n", spec);
+        batch_n_rejected++;
+    }
+}
+
+static int
+batch_cmp_files(const void* a, const void* b)
+{
+    return strcmp(((const BATCH_FILE*) a)->path, ((const BATCH_FILE*) b)->path);
+}
+
+/* Create all missing parent directories of the path. */
+static void
+batch_mkdirs(char* path)
+{
+    char* p;
+
+    for(p = strchr(path + 1, '/'); p != NULL; p = strchr(p + 1, '/')) {
+        *p = '\0';
+        if(mkdir(path, 0777) != 0  &&  errno != EEXIST) {
+            *p = '/';
+            return;
+        }
+        *p = '/';
+    }
+}
+
+static int
+batch_process_file(BATCH_WORKER* w, const BATCH_FILE* file)
+{
+    const char* rel = file->path + file->rel_off;
+    const char* ext = strrchr(rel, '.');
+    size_t stem_len;
+    char* out_path;
+    FILE* f;
+    int ret;
+
+    f = fopen(file->path, "rb");
+    if(f == NULL) {
+        fprintf(stderr, "Cannot open %s.\n", file->path);
+        return -1;
+    }
+    w->buf_in.size = 0;
+    ret = membuf_read(&w->buf_in, f);
+    fclose(f);
+    if(ret != 0) {
+        fprintf(stderr, "Cannot read %s.\n", file->path);
+        return -1;
+    }
+
+    w->buf_out.size = 0;
+    if(w->buf_out.asize < w->buf_in.size + w->buf_in.size/8 + 64)
+        membuf_grow(&w->buf_out, w->buf_in.size + w->buf_in.size/8 + 64);
+    if(render_document(w->buf_in.data, w->buf_in.size, process_output,
+                       (void*) &w->buf_out, &batch_opts) != 0) {
+        fprintf(stderr, "Parsing failed: %s.\n", file->path);
+        return -1;
+    }
+
+    /* Output path: --out-dir + relative input path with the extension
+     * replaced by the one of the output format. */
+    stem_len = (ext != NULL  &&  strchr(ext, '/') == NULL) ? (size_t)(ext - rel) : strlen(rel);
+    out_path = malloc(strlen(out_dir) + 1 + stem_len + strlen(format_ext[output_format]) + 1);
+    if(out_path == NULL) {
+        fprintf(stderr, "batch_process_file: malloc() failed.\n");
+        exit(1);
+    }
+    sprintf(out_path, "%s/%.*s%s", out_dir, (int) stem_len, rel, format_ext[output_format]);
+
+    batch_mkdirs(out_path);
+    f = fopen(out_path, "wb");
+    if(f == NULL) {
+        fprintf(stderr, "Cannot open %s.\n", out_path);
+        free(out_path);
+        return -1;
+    }
+    if(fwrite(w->buf_out.data, 1, w->buf_out.size, f) != w->buf_out.size)
+        ret = -1;
+    if(fclose(f) != 0)
+        ret = -1;
+    if(ret != 0)
+        fprintf(stderr, "Cannot write %s.\n", out_path);
+    free(out_path);
+
+    w->in_bytes += w->buf_in.size;
+    w->out_bytes += w->buf_out.size;
+    return ret;
+}
+
+static void*
+batch_worker(void* arg)
+{
+    BATCH_WORKER* w = (BATCH_WORKER*) arg;
+    size_t i;
+
+    while(1) {
+        pthread_mutex_lock(&batch_mutex);
+        i = batch_next_file++;
+        pthread_mutex_unlock(&batch_mutex);
+        if(i >= batch_n_files)
+            break;
+
+        w->n_files++;
+        if(batch_process_file(w, &batch_files[i]) != 0)
+            w->n_failed++;
+    }
+
+    return NULL;
+}
+
+static int
+process_batch(const char** inputs, int n_inputs)
+{
+    BATCH_WORKER* workers;
+    struct timespec t0, t1;
+    size_t n_files = 0, n_failed = 0, in_bytes = 0, out_bytes = 0;
+    size_t k;
+    int n_workers = batch_jobs;
+    int n_started;
+    int i;
+
+    for(i = 0; i < n_inputs; i++)
+        batch_add_input(inputs[i]);
+    if(batch_n_files == 0) {
+        fprintf(stderr, "No input files.\n");
+        return 1;
+    }
+    qsort(batch_files, batch_n_files, sizeof(BATCH_FILE), batch_cmp_files);
+    render_opts_init(&batch_opts);
+
+    if(n_workers <= 0)
+        n_workers = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if(n_workers <= 0)
+        n_workers = 1;
+    if((size_t) n_workers > batch_n_files)
+        n_workers = (int) batch_n_files;
+
+    workers = calloc(n_workers, sizeof(BATCH_WORKER));
+    if(workers == NULL) {
+        fprintf(stderr, "process_batch: calloc() failed.\n");
+        exit(1);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for(n_started = 0; n_started < n_workers; n_started++) {
+        membuf_init(&workers[n_started].buf_in, 32 * 1024);
+        membuf_init(&workers[n_started].buf_out, 64 * 1024);
+        if(pthread_create(&workers[n_started].thread, NULL, batch_worker, &workers[n_started]) != 0)
+            break;
+    }
+    if(n_started == 0) {
+        /* No threads available; do the work on this one. */
+        batch_worker(&workers[0]);
+        n_started = 1;
+    } else {
+        for(i = 0; i < n_started; i++)
+            pthread_join(workers[i].thread, NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    for(i = 0; i < n_workers; i++) {
+        n_files += workers[i].n_files;
+        n_failed += workers[i].n_failed;
+        in_bytes += workers[i].in_bytes;
+        out_bytes += workers[i].out_bytes;
+        membuf_fini(&workers[i].buf_in);
+        membuf_fini(&workers[i].buf_out);
+    }
+    free(workers);
+
+    if(want_stat) {
+        double elapsed = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+        if(elapsed <= 0)
+            elapsed = 1e-9;
+        /* Inputs rejected before rendering count as processed and failed. */
+        fprintf(stderr, "Processed %lu files (%lu failed) with %d threads in %.3f s.\n",
+                (unsigned long) (n_files + batch_n_rejected),
+                (unsigned long) (n_failed + batch_n_rejected),
+                n_started, elapsed);
+        fprintf(stderr, "Throughput: %.1f files/s, %.2f MB/s input, %.2f MB/s output.\n",
+                (double) n_files / elapsed, (double) in_bytes / 1e6 / elapsed,
+                (double) out_bytes / 1e6 / elapsed);
+    }
+
+    for(k = 0; k < batch_n_files; k++)
+        free(batch_files[k].path);
+    free(batch_files);
+
+    return (n_failed + batch_n_rejected > 0) ? 1 : 0;
+}
+
+#endif  /* MD4X_CLI_POSIX */
+
+
+/************************
+ ***  Benchmark mode  ***
+ ************************/
+
+/* With --bench=N, the input is rendered N times (after one warm-up run) and
+ * the wall-clock time of each run is recorded. The rendered output is not
+ * written anywhere; a report with min/median/p99 and throughput is printed
+ * instead, as a table or, with --bench-json, as JSON for tracking results
+ * across versions.
+ */
+
+typedef struct {
+    OutputFormat format;
+    double min;         /* Seconds. */
+    double median;
+    double p99;
+    size_t out_size;
+} BENCH_RESULT;
+
+static double
+bench_now(void)
+{
+    struct timespec ts;
+
+#ifdef MD4X_CLI_POSIX
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#else
+    timespec_get(&ts, TIME_UTC);
+#endif
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static int
+bench_cmp_times(const void* a, const void* b)
+{
+    double ta = *(const double*) a;
+    double tb = *(const double*) b;
+    return (ta < tb) ? -1 : (ta > tb) ? 1 : 0;
+}
+
+static int
+bench_format(const struct input* input, OutputFormat format, double* times,
+             struct membuffer* buf_out, BENCH_RESULT* result)
+{
+    RENDER_OPTS opts;
+    double t0;
+    int i;
+
+    render_opts_init(&opts);
+    opts.format = format;
+
+    /* Warm-up run; it also sizes the output buffer. */
+    buf_out->size = 0;
+    if(render_document(input->data, input->size, process_output,
+                (void*) buf_out, &opts) != 0)
+        return -1;
+    result->out_size = buf_out->size;
+
+    for(i = 0; i < bench_runs; i++) {
+        buf_out->size = 0;
+        t0 = bench_now();
+        render_document(input->data, input->size, process_output,
+                (void*) buf_out, &opts);
+        times[i] = bench_now() - t0;
+    }
+
+    qsort(times, bench_runs, sizeof(double), bench_cmp_times);
+    result->format = format;
+    result->min = times[0];
+    result->median = (bench_runs % 2) ? times[bench_runs / 2]
+                : (times[bench_runs / 2 - 1] + times[bench_runs / 2]) / 2;
+    result->p99 = times[(bench_runs * 99 + 99) / 100 - 1];
+    return 0;
+}
+
+static void
+bench_print_time(FILE* out, double t)
+{
+    if(t < 1e-3)
+        fprintf(out, " %9.2f us", t * 1e6);
+    else if(t < 1)
+        fprintf(out, " %9.3f ms", t * 1e3);
+    else
+        fprintf(out, " %9.3f s ", t);
+}
+
+static void
+bench_report(FILE* out, const BENCH_RESULT* results, int n_results, size_t in_size)
+{
+    int i;
+
+    if(want_bench_json) {
+        fprintf(out, "{\"version\":\"%d.%d.%d\",\"input_bytes\":%lu,\"runs\":%d,\"results\":[",
+                MD_VERSION_MAJOR, MD_VERSION_MINOR, MD_VERSION_RELEASE,
+                (unsigned long) in_size, bench_runs);
+        for(i = 0; i < n_results; i++) {
+            const BENCH_RESULT* r = &results[i];
+            fprintf(out, "%s{\"format\":\"%s\",\"min_ns\":%.0f,\"median_ns\":%.0f,"
+                    "\"p99_ns\":%.0f,\"mb_per_s\":%.2f,\"output_bytes\":%lu}",
+                    (i > 0) ? "," : "", format_name[r->format],
+                    r->min * 1e9, r->median * 1e9, r->p99 * 1e9,
+                    (r->median > 0) ? (double) in_size / 1e6 / r->median : 0.0,
+                    (unsigned long) r->out_size);
+        }
+        fprintf(out, "]}\n");
+        return;
+    }
+
+    fprintf(out, "Input: %lu bytes, %d runs\n\n", (unsigned long) in_size, bench_runs);
+    fprintf(out, "%-10s %12s %12s %12s %10s\n", "format", "min", "median", "p99", "MB/s");
+    for(i = 0; i < n_results; i++) {
+        const BENCH_RESULT* r = &results[i];
+        fprintf(out, "%-10s", format_name[r->format]);
+        bench_print_time(out, r->min);
+        bench_print_time(out, r->median);
+        bench_print_time(out, r->p99);
+        fprintf(out, " %10.2f\n", (r->median > 0) ? (double) in_size / 1e6 / r->median : 0.0);
+    }
+}
+
+static int
+process_bench(const char* in_path, FILE* in, FILE* out)
+{
+    struct input input;
+    struct membuffer buf_out;
+    BENCH_RESULT results[FORMAT_HEAL + 1];
+    double* times;
+    int n_results = 0;
+    int ret = 0;
+    int f;
+
+    if(input_open(&input, in, 0) != 0) {
+        fprintf(stderr, "Cannot read %s.\n", in_path);
+        input_close(&input);
+        return -1;
+    }
+
+    times = malloc(bench_runs * sizeof(double));
+    if(times == NULL) {
+        fprintf(stderr, "process_bench: malloc() failed.\n");
+        exit(1);
+    }
+    membuf_init(&buf_out, input.size + input.size/8 + 64);
+
+    for(f = FORMAT_HTML; f <= FORMAT_HEAL; f++) {
+        if(!want_bench_all  &&  f != (int) output_format)
+            continue;
+        if(bench_format(&input, (OutputFormat) f, times, &buf_out, &results[n_results]) != 0) {
+            fprintf(stderr, "Parsing failed (%s).\n", format_name[f]);
+            ret = -1;
+            continue;
+        }
+        n_results++;
+    }
+
+    bench_report(out, results, n_results, input.size);
+
     membuf_fini(&buf_out);
+    free(times);
+    input_close(&input);
+    return ret;
+}
+
+
+/*********************
+ ***  Server mode  ***
+ *********************/
+
+/* With --serve, requests are read from standard input and answered on
+ * standard output until the end of input. With --socket=PATH, the server
+ * listens on a Unix socket instead and serves each client connection on its
+ * own thread the same way. Input and output buffers are kept across requests.
+ *
+ * All integers are 32-bit little-endian.
+ *
+ * Request:   u32 format        0 html, 1 text, 2 json, 3 ansi, 4 markdown, 5 heal
+ *            u32 parser_flags  MD_FLAG_xxxx bitmask (e.g. MD_DIALECT_ALL)
+ *            u32 options       SERVE_OPT_xxxx bitmask
+ *            u32 title_size    size of the --html-title value
+ *            u32 css_size      size of the --html-css value
+ *            u32 input_size
+ *            title, css and input bytes
+ *
+ * Response:  u32 status        0 on success
+ *            u32 size
+ *            output bytes (or an error message if status is not 0)
+ *
+ * A request whose title, css and input exceed SERVE_MAX_REQUEST_SIZE bytes
+ * together is answered with status 1 and ends the connection, since its
+ * payload is not read. An output that does not fit the u32 size is answered
+ * with status 1 too.
+ */
+
+#define SERVE_OPT_HEAL          0x0001
+#define SERVE_OPT_FULL_HTML     0x0002
+
+#define SERVE_HEADER_SIZE       (6 * 4)
+#define SERVE_MAX_REQUEST_SIZE  (256u * 1024 * 1024)
+
+static unsigned
+serve_get_u32(const unsigned char* p)
+{
+    return (unsigned) p[0] | ((unsigned) p[1] << 8) |
+           ((unsigned) p[2] << 16) | ((unsigned) p[3] << 24);
+}
+
+static void
+serve_put_u32(unsigned char* p, unsigned val)
+{
+    p[0] = (unsigned char) (val & 0xff);
+    p[1] = (unsigned char) ((val >> 8) & 0xff);
+    p[2] = (unsigned char) ((val >> 16) & 0xff);
+    p[3] = (unsigned char) ((val >> 24) & 0xff);
+}
+
+static int
+serve_respond(FILE* out, unsigned status, const char* data, size_t size)
+{
+    static const char too_large[] = "Output too large.";
+    unsigned char header[8];
+
+    if(size > 0xffffffffu) {
+        status = 1;
+        data = too_large;
+        size = sizeof(too_large) - 1;
+    }
+
+    serve_put_u32(header, status);
+    serve_put_u32(header + 4, (unsigned) size);
+    if(fwrite(header, 1, sizeof(header), out) != sizeof(header)  ||
+       fwrite(data, 1, size, out) != size  ||  fflush(out) != 0)
+        return -1;
+    return 0;
+}
+
+/* Serve requests until the end of input. Returns -1 on a truncated or
+ * oversized request, or a write error. */
+static int
+serve_stream(FILE* in, FILE* out)
+{
+    unsigned char header[SERVE_HEADER_SIZE];
+    struct membuffer buf_str;
+    struct membuffer buf_in;
+    struct membuffer buf_out;
+    RENDER_OPTS opts;
+    unsigned format, options, title_size, css_size, input_size;
+    size_t str_size;
+    size_t n;
+    int ret = 0;
 
+    membuf_init(&buf_str, 256);
+    membuf_init(&buf_in, 64 * 1024);
+    membuf_init(&buf_out, 64 * 1024);
+
+    while(1) {
+        n = fread(header, 1, SERVE_HEADER_SIZE, in);
+        if(n == 0  &&  feof(in))
+            break;
+        if(n != SERVE_HEADER_SIZE) {
+            fprintf(stderr, "Truncated request header.\n");
+            ret = -1;
+            break;
+        }
+
+        format = serve_get_u32(header);
+        title_size = serve_get_u32(header + 12);
+        css_size = serve_get_u32(header + 16);
+        input_size = serve_get_u32(header + 20);
+
+        if(title_size > SERVE_MAX_REQUEST_SIZE  ||
+           css_size > SERVE_MAX_REQUEST_SIZE - title_size  ||
+           input_size > SERVE_MAX_REQUEST_SIZE - title_size - css_size) {
+            static const char msg[] = "Request too large.";
+            fprintf(stderr, "%s\n", msg);
+            serve_respond(out, 1, msg, sizeof(msg) - 1);
+            ret = -1;
+            break;
+        }
+
+        /* Read the title and css strings (zero-terminated) and the input. */
+        str_size = (size_t) title_size + css_size + 2;
+        if(buf_str.asize < str_size)
+            membuf_grow(&buf_str, str_size);
+        if(buf_in.asize < input_size)
+            membuf_grow(&buf_in, input_size);
+        if(fread(buf_str.data, 1, title_size, in) != title_size  ||
+           fread(buf_str.data + title_size + 1, 1, css_size, in) != css_size  ||
+           fread(buf_in.data, 1, input_size, in) != input_size) {
+            fprintf(stderr, "Truncated request.\n");
+            ret = -1;
+            break;
+        }
+        buf_str.data[title_size] = '\0';
+        buf_str.data[title_size + 1 + css_size] = '\0';
+
+        if(format > FORMAT_HEAL) {
+            static const char msg[] = "Unknown format.";
+            if(serve_respond(out, 1, msg, sizeof(msg) - 1) != 0) {
+                ret = -1;
+                break;
+            }
+            continue;
+        }
+
+        render_opts_init(&opts);
+        options = serve_get_u32(header + 8);
+        opts.format = (OutputFormat) format;
+        opts.p_flags = serve_get_u32(header + 4);
+        opts.heal = (options & SERVE_OPT_HEAL) != 0;
+        opts.fullhtml = (options & SERVE_OPT_FULL_HTML) != 0;
+        opts.html_title = (title_size > 0) ? buf_str.data : NULL;
+        opts.css_url = (css_size > 0) ? buf_str.data + title_size + 1 : NULL;
+
+        buf_out.size = 0;
+        if(render_document(buf_in.data, input_size,
+                    process_output, (void*) &buf_out, &opts) != 0) {
+            static const char msg[] = "Parsing failed.";
+            if(serve_respond(out, 1, msg, sizeof(msg) - 1) != 0) {
+                ret = -1;
+                break;
+            }
+            continue;
+        }
+
+        if(serve_respond(out, 0, buf_out.data, buf_out.size) != 0) {
+            ret = -1;
+            break;
+        }
+    }
+
+    membuf_fini(&buf_str);
+    membuf_fini(&buf_in);
+    membuf_fini(&buf_out);
     return ret;
 }
 
+#ifdef MD4X_CLI_POSIX
+
+static void*
+serve_connection(void* arg)
+{
+    int fd = *(int*) arg;
+    int fd_out;
+    FILE* in;
+    FILE* out = NULL;
+
+    free(arg);
+    in = fdopen(fd, "rb");
+    fd_out = dup(fd);
+    if(fd_out >= 0)
+        out = fdopen(fd_out, "wb");
+    if(in != NULL  &&  out != NULL)
+        serve_stream(in, out);
+
+    if(out != NULL)
+        fclose(out);
+    else if(fd_out >= 0)
+        close(fd_out);
+    if(in != NULL)
+        fclose(in);
+    else
+        close(fd);
+    return NULL;
+}
+
+static int
+serve_socket(const char* path)
+{
+    struct sockaddr_un addr;
+    struct stat st;
+    pthread_t thread;
+    int sock;
+    int* fd;
+
+    if(strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", path);
+        return 1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    /* Replace a stale socket left behind by a previous server. */
+    if(stat(path, &st) == 0  &&  S_ISSOCK(st.st_mode))
+        unlink(path);
+
+    sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(sock < 0  ||  bind(sock, (struct sockaddr*) &addr, sizeof(addr)) != 0  ||
+       listen(sock, 64) != 0) {
+        fprintf(stderr, "Cannot listen on %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+
+    while(1) {
+        fd = malloc(sizeof(int));
+        if(fd == NULL) {
+            fprintf(stderr, "serve_socket: malloc() failed.\n");
+            exit(1);
+        }
+        *fd = accept(sock, NULL, NULL);
+        if(*fd < 0) {
+            free(fd);
+            if(errno == EINTR  ||  errno == ECONNABORTED)
+                continue;
+            fprintf(stderr, "accept() failed: %s\n", strerror(errno));
+            break;
+        }
+        if(pthread_create(&thread, NULL, serve_connection, fd) != 0) {
+            /* Out of threads; serve the client on this one. */
+            serve_connection(fd);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+
+    close(sock);
+    return 1;
+}
+
+#endif  /* MD4X_CLI_POSIX */
+
+static int
+process_serve(void)
+{
+#ifdef MD4X_CLI_POSIX
+    /* A client going away must not kill the server. */
+    signal(SIGPIPE, SIG_IGN);
+
+    if(socket_path != NULL)
+        return serve_socket(socket_path);
+#else
+    if(socket_path != NULL) {
+        fprintf(stderr, "--socket is not supported on this platform.\n");
+        return 1;
+    }
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+    return (serve_stream(stdin, stdout) == 0) ? 0 : 1;
+}
 
 static const CMDLINE_OPTION cmdline_options[] = {
     { 'o', "output",                        'o', CMDLINE_OPTFLAG_REQUIREDARG },
@@ -294,12 +1459,29 @@ static const CMDLINE_OPTION cmdline_options[] = {
 
     { 't', "format",                        '3', CMDLINE_OPTFLAG_REQUIREDARG },
 
+    {  0,  "batch",                         'B', 0 },
+    {  0,  "out-dir",                       'O', CMDLINE_OPTFLAG_REQUIREDARG },
+    { 'j', "jobs",                          'j', CMDLINE_OPTFLAG_REQUIREDARG },
+
+    {  0,  "bench",                         'n', CMDLINE_OPTFLAG_REQUIREDARG },
+    {  0,  "bench-all",                     'A', 0 },
+    {  0,  "bench-json",                    'J', 0 },
+    {  0,  "trace",                         'T', CMDLINE_OPTFLAG_REQUIREDARG },
+
+    {  0,  "serve",                         'S', 0 },
+    {  0,  "socket",                        'U', CMDLINE_OPTFLAG_REQUIREDARG },
+
     {  0,  "html-title",                    '1', CMDLINE_OPTFLAG_REQUIREDARG },
     {  0,  "html-css",                      '2', CMDLINE_OPTFLAG_REQUIREDARG },
 
     /* Undocumented option for replaying test cases from fuzzers. */
     {  0,  "replay-fuzz",                   'r', 0 },
 
+    /* Undocumented options for test/wide-offsets-test.py: append the code
+     * block or top-level block metadata to the HTML output. */
+    {  0,  "html-code-meta",                '5', 0 },
+    {  0,  "html-block-meta",               '6', 0 },
+
     {  0,  NULL,                             0,  0 }
 };
 
@@ -308,13 +1490,23 @@ usage(void)
 {
     printf(
         "Usage: md4x [OPTION]... [FILE]\n"
+        "       md4x --batch --out-dir=DIR [OPTION]... INPUT...\n"
+        "       md4x --serve [--socket=PATH]\n"
         "Convert input FILE (or standard input) in Markdown format.\n"
         "\n"
         "General options:\n"
         "  -o  --output=FILE    Output file (default is standard output)\n"
         "  -t, --format=FORMAT  Output format: html (default), text, json, ansi, markdown, heal\n"
         "      --heal           Heal incomplete markdown before rendering\n"
-        "  -s, --stat           Measure time of input parsing\n"
+        "  -s, --stat           Measure time of input parsing and print parser statistics\n"
+        "                       (with --batch, print aggregate throughput instead)\n"
+        "      --bench=N        Render the input N times and report min/median/p99\n"
+        "                       wall-clock time and MB/s instead of the output\n"
+        "      --bench-all      With --bench, measure every output format\n"
+        "      --bench-json     With --bench, print the report as JSON\n"
+        "      --trace=FILE     Write a Chrome trace (JSON) of the parser phases and\n"
+        "                       renderer callbacks to FILE; needs a tracing build\n"
+        "                       (zig build -Dtrace=true)\n"
         "  -h, --help           Display this help and exit\n"
         "  -v, --version        Display version and exit\n"
         "\n"
@@ -323,6 +1515,18 @@ usage(void)
         "      --html-title=TITLE Sets the title of the document\n"
         "      --html-css=URL   In full HTML mode add a css link\n"
         "\n"
+        "Batch options:\n"
+        "      --batch          Convert many files; each INPUT is a directory (searched\n"
+        "                       recursively for *.md, *.markdown), a glob pattern or\n"
+        "                       @FILE with one path per line (@- reads standard input)\n"
+        "      --out-dir=DIR    Write outputs under DIR, mirroring the input tree\n"
+        "  -j, --jobs=N         Number of worker threads (default: number of CPUs)\n"
+        "\n"
+        "Server options:\n"
+        "      --serve          Answer length-prefixed render requests on standard\n"
+        "                       input/output until end of input (see md4x(1))\n"
+        "      --socket=PATH    With --serve, listen on a Unix socket instead\n"
+        "\n"
     );
 }
 
@@ -332,7 +1536,8 @@ version(void)
     printf("%d.%d.%d\n", MD_VERSION_MAJOR, MD_VERSION_MINOR, MD_VERSION_RELEASE);
 }
 
-static const char* input_path = NULL;
+static const char** input_paths = NULL;
+static int n_input_paths = 0;
 static const char* output_path = NULL;
 
 static int
@@ -342,12 +1547,12 @@ cmdline_callback(int opt, char const* value, void* data)
 
     switch(opt) {
         case 0:
-            if(input_path) {
-                fprintf(stderr, "Too many arguments. Only one input file can be specified.\n");
-                fprintf(stderr, "Use --help for more info.\n");
+            input_paths = realloc(input_paths, (n_input_paths + 1) * sizeof(const char*));
+            if(input_paths == NULL) {
+                fprintf(stderr, "cmdline_callback: realloc() failed.\n");
                 exit(1);
             }
-            input_path = value;
+            input_paths[n_input_paths++] = value;
             break;
 
         case 'o':   output_path = value; break;
@@ -355,6 +1560,29 @@ cmdline_callback(int opt, char const* value, void* data)
         case '4':   want_heal = 1; break;
         case 's':   want_stat = 1; break;
         case 'r':   want_replay_fuzz = 1; break;
+        case '5':   renderer_flags |= MD_HTML_FLAG_CODE_META; break;
+        case '6':   renderer_flags |= MD_HTML_FLAG_BLOCK_META; break;
+        case 'B':   want_batch = 1; break;
+        case 'n':
+            bench_runs = atoi(value);
+            if(bench_runs <= 0) {
+                fprintf(stderr, "Invalid number of benchmark runs: %s\n", value);
+                exit(1);
+            }
+            break;
+        case 'A':   want_bench_all = 1; break;
+        case 'J':   want_bench_json = 1; break;
+        case 'T':   trace_path = value; break;
+        case 'S':   want_serve = 1; break;
+        case 'U':   socket_path = value; break;
+        case 'O':   out_dir = value; break;
+        case 'j':
+            batch_jobs = atoi(value);
+            if(batch_jobs <= 0) {
+                fprintf(stderr, "Invalid number of jobs: %s\n", value);
+                exit(1);
+            }
+            break;
         case 'h':   usage(); exit(0); break;
         case 'v':   version(); exit(0); break;
 
@@ -391,11 +1619,25 @@ cmdline_callback(int opt, char const* value, void* data)
     return 0;
 }
 
+/* With --trace, write the recorded events once all the work is done. */
+static int
+finish_trace(int ret)
+{
+#ifdef MD4X_TRACE
+    if(trace_path != NULL  &&  md_trace_dump(trace_path) != 0) {
+        fprintf(stderr, "Cannot write %s.\n", trace_path);
+        return 1;
+    }
+#endif
+    return ret;
+}
+
 int
 main(int argc, char** argv)
 {
     FILE* in = stdin;
     FILE* out = stdout;
+    const char* input_path;
     int ret = 0;
 
     if(cmdline_read(cmdline_options, argc, argv, cmdline_callback, NULL) != 0) {
@@ -403,6 +1645,49 @@ main(int argc, char** argv)
         exit(1);
     }
 
+#ifndef MD4X_TRACE
+    if(trace_path != NULL) {
+        fprintf(stderr, "--trace requires a tracing build (zig build -Dtrace=true).\n");
+        exit(1);
+    }
+#endif
+
+    if(want_serve) {
+        if(n_input_paths > 0  ||  want_batch) {
+            fprintf(stderr, "--serve takes no input files.\n");
+            fprintf(stderr, "Use --help for more info.\n");
+            exit(1);
+        }
+        return process_serve();
+    }
+
+    if(want_batch) {
+#ifdef MD4X_CLI_POSIX
+        if(out_dir == NULL  ||  n_input_paths == 0) {
+            fprintf(stderr, "--batch requires --out-dir and at least one input.\n");
+            fprintf(stderr, "Use --help for more info.\n");
+            exit(1);
+        }
+        return finish_trace(process_batch(input_paths, n_input_paths));
+#else
+        fprintf(stderr, "--batch is not supported on this platform.\n");
+        exit(1);
+#endif
+    }
+
+    if((want_bench_all  ||  want_bench_json)  &&  bench_runs == 0) {
+        fprintf(stderr, "--bench-all and --bench-json require --bench.\n");
+        fprintf(stderr, "Use --help for more info.\n");
+        exit(1);
+    }
+
+    if(n_input_paths > 1) {
+        fprintf(stderr, "Too many arguments. Only one input file can be specified.\n");
+        fprintf(stderr, "Use --help for more info.\n");
+        exit(1);
+    }
+    input_path = (n_input_paths > 0) ? input_paths[0] : NULL;
+
     if(input_path != NULL && strcmp(input_path, "-") != 0) {
         in = fopen(input_path, "rb");
         if(in == NULL) {
@@ -418,11 +1703,14 @@ main(int argc, char** argv)
         }
     }
 
-    ret = process_file((input_path != NULL) ? input_path : "<stdin>", in, out);
+    if(bench_runs > 0)
+        ret = process_bench((input_path != NULL) ? input_path : "<stdin>", in, out);
+    else
+        ret = process_file((input_path != NULL) ? input_path : "<stdin>", in, out);
     if(in != stdin)
         fclose(in);
     if(out != stdout)
         fclose(out);
 
-    return ret;
+    return finish_trace(ret);
 }
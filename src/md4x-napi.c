@@ -24,6 +24,7 @@
  */
 
 #include <node_api.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 #include "md4x.h"
@@ -34,13 +35,14 @@
 #include "md4x-text.h"
 #include "md4x-markdown.h"
 #include "md4x-heal.h"
+#include "md4x-multi.h"
 
 
 /* Growable output buffer */
 typedef struct {
     char* data;
-    unsigned size;
-    unsigned cap;
+    MD_SIZE size;
+    MD_SIZE cap;
     int error;
 } napi_buf;
 
@@ -49,7 +51,7 @@ static void napi_buf_append(const MD_CHAR* text, MD_SIZE size, void* userdata)
     napi_buf* buf = (napi_buf*) userdata;
     if(buf->error) return;
     if(buf->size + size > buf->cap) {
-        unsigned new_cap = buf->cap + buf->cap / 2 + size + 256;
+        MD_SIZE new_cap = buf->cap + buf->cap / 2 + size + 256;
         char* p = (char*) realloc(buf->data, new_cap);
         if(!p) { buf->error = 1; return; }
         buf->data = p;
@@ -60,16 +62,63 @@ static void napi_buf_append(const MD_CHAR* text, MD_SIZE size, void* userdata)
 }
 
 
-/* Generic renderer wrapper */
-typedef int (*md4x_render_fn)(const MD_CHAR*, MD_SIZE,
-    void (*)(const MD_CHAR*, MD_SIZE, void*), void*, unsigned, unsigned);
+/* A JS number as an MD_LIMITS field of the given maximum (0 = unlimited). */
+static unsigned long long limit_value(double v, unsigned long long max)
+{
+    if(!(v > 0)) return 0;
+    if(v >= (double) max) return max;
+    return (unsigned long long) v;
+}
+
 
+/* Read an optional limits argument: an array of the MD_LIMITS fields (in
+ * declaration order, 0 = unlimited). Returns whether it was given. */
+static int get_limits(napi_env env, napi_value value, MD_LIMITS* limits)
+{
+    bool is_array = false;
+    double values[5] = { 0 };
+    uint32_t k;
+
+    memset(limits, 0, sizeof(MD_LIMITS));
+    napi_is_array(env, value, &is_array);
+    if(!is_array)
+        return 0;
+
+    for(k = 0; k < 5; k++) {
+        napi_value v;
+        if(napi_get_element(env, value, k, &v) == napi_ok)
+            napi_get_value_double(env, v, &values[k]);
+    }
+    limits->max_depth = (unsigned) limit_value(values[0], UINT_MAX);
+    limits->max_marks = (unsigned) limit_value(values[1], UINT_MAX);
+    limits->max_blocks = (unsigned) limit_value(values[2], UINT_MAX);
+    limits->max_output_bytes = (unsigned long) limit_value(values[3], ULONG_MAX);
+    limits->max_steps = limit_value(values[4], ULLONG_MAX);
+    return 1;
+}
+
+/* Throw the error for a failed md_render_multi() (or md_heal()). */
+static void throw_render_error(napi_env env, int ret, const char* msg)
+{
+    if(ret == MD_LIMIT_EXCEEDED)
+        napi_throw_error(env, "MD4X_LIMIT_EXCEEDED", "Markdown limits exceeded");
+    else
+        napi_throw_error(env, NULL, msg);
+}
+
+
+/* Generic renderer wrapper: (input, flags, limits) -> string, or a Buffer
+ * for the Meta and Blocks variants. flags are the renderer flags (the HEAL one
+ * included), OR-ed with extra_flags; limits is as in get_limits(). */
 static napi_value
-render_impl(napi_env env, napi_callback_info info, md4x_render_fn fn)
+render_impl(napi_env env, napi_callback_info info, MD_RENDER_FORMAT format,
+            unsigned extra_flags, int as_buffer)
 {
-    size_t argc = 2;
-    napi_value argv[2];
-    unsigned renderer_flags = 0;
+    size_t argc = 3;
+    napi_value argv[3];
+    unsigned renderer_flags = extra_flags;
+    MD_LIMITS limits;
+    int with_limits = 0;
     napi_get_cb_info(env, info, &argc, argv, NULL, NULL);
 
     if(argc < 1) {
@@ -91,24 +140,37 @@ render_impl(napi_env env, napi_callback_info info, md4x_render_fn fn)
     if(argc >= 2) {
         uint32_t flags;
         if(napi_get_value_uint32(env, argv[1], &flags) == napi_ok) {
-            renderer_flags = flags;
+            renderer_flags |= flags;
         }
     }
 
+    /* Get optional limits (third arg) */
+    if(argc >= 3)
+        with_limits = get_limits(env, argv[2], &limits);
+
     /* Render with all extensions enabled */
     napi_buf buf = { NULL, 0, 0, 0 };
-    int ret = fn(input, (unsigned) input_size, napi_buf_append, &buf,
-                 MD_DIALECT_ALL, renderer_flags);
+    MD_RENDER_TARGET target = { format, renderer_flags, napi_buf_append, &buf };
+    int ret = md_render_multi(input, (MD_SIZE) input_size, &target, 1, MD_DIALECT_ALL,
+                              renderer_flags & MD_MULTI_FLAG_HEAL,
+                              with_limits ? &limits : NULL, NULL);
     free(input);
+    if(ret == 0 && buf.error)
+        ret = -1;
 
-    if(ret != 0 || buf.error) {
+    if(ret != 0) {
         free(buf.data);
-        napi_throw_error(env, NULL, "Markdown parsing failed");
+        throw_render_error(env, ret, "Markdown parsing failed");
         return NULL;
     }
 
     napi_value result;
-    napi_create_string_utf8(env, buf.data ? buf.data : "", buf.size, &result);
+    if(as_buffer) {
+        void* result_data;
+        napi_create_buffer_copy(env, buf.size, buf.data ? buf.data : "", &result_data, &result);
+    } else {
+        napi_create_string_utf8(env, buf.data ? buf.data : "", buf.size, &result);
+    }
     free(buf.data);
     return result;
 }
@@ -118,104 +180,58 @@ render_impl(napi_env env, napi_callback_info info, md4x_render_fn fn)
 
 static napi_value md4x_napi_to_html(napi_env env, napi_callback_info info)
 {
-    size_t argc = 2;
-    napi_value argv[2];
-    napi_get_cb_info(env, info, &argc, argv, NULL, NULL);
-
-    if(argc < 1) {
-        napi_throw_error(env, NULL, "Expected 1 argument");
-        return NULL;
-    }
-
-    /* Get input string */
-    size_t input_size;
-    napi_get_value_string_utf8(env, argv[0], NULL, 0, &input_size);
-    char* input = (char*) malloc(input_size + 1);
-    if(!input) {
-        napi_throw_error(env, NULL, "Allocation failed");
-        return NULL;
-    }
-    napi_get_value_string_utf8(env, argv[0], input, input_size + 1, &input_size);
-
-    /* Get optional renderer flags (second arg) */
-    unsigned renderer_flags = 0;
-    if(argc >= 2) {
-        uint32_t flags;
-        if(napi_get_value_uint32(env, argv[1], &flags) == napi_ok) {
-            renderer_flags = flags;
-        }
-    }
-
-    /* Render */
-    napi_buf buf = { NULL, 0, 0, 0 };
-    int ret = md_html(input, (unsigned) input_size, napi_buf_append, &buf,
-                      MD_DIALECT_ALL, renderer_flags);
-    free(input);
-
-    if(ret != 0 || buf.error) {
-        free(buf.data);
-        napi_throw_error(env, NULL, "Markdown parsing failed");
-        return NULL;
-    }
-
-    napi_value result;
-    napi_create_string_utf8(env, buf.data ? buf.data : "", buf.size, &result);
-    free(buf.data);
-    return result;
+    return render_impl(env, info, MD_RENDER_HTML, 0, 0);
 }
 
 static napi_value md4x_napi_to_html_meta(napi_env env, napi_callback_info info)
 {
-    size_t argc = 1;
-    napi_value argv[1];
-    napi_get_cb_info(env, info, &argc, argv, NULL, NULL);
+    return render_impl(env, info, MD_RENDER_HTML, MD_HTML_FLAG_CODE_META, 1);
+}
 
-    if(argc < 1) {
-        napi_throw_error(env, NULL, "Expected 1 argument");
-        return NULL;
-    }
+static napi_value md4x_napi_to_html_blocks(napi_env env, napi_callback_info info)
+{
+    return render_impl(env, info, MD_RENDER_HTML, MD_HTML_FLAG_BLOCK_META, 1);
+}
 
-    size_t input_size;
-    napi_get_value_string_utf8(env, argv[0], NULL, 0, &input_size);
-    char* input = (char*) malloc(input_size + 1);
-    if(!input) {
-        napi_throw_error(env, NULL, "Allocation failed");
-        return NULL;
-    }
-    napi_get_value_string_utf8(env, argv[0], input, input_size + 1, &input_size);
+static napi_value md4x_napi_to_ast(napi_env env, napi_callback_info info)
+{
+    return render_impl(env, info, MD_RENDER_AST, 0, 0);
+}
 
-    napi_buf buf = { NULL, 0, 0 };
-    int ret = md_html(input, (unsigned) input_size, napi_buf_append, &buf,
-                      MD_DIALECT_ALL, MD_HTML_FLAG_CODE_META);
-    free(input);
+static napi_value md4x_napi_to_ansi(napi_env env, napi_callback_info info)
+{
+    return render_impl(env, info, MD_RENDER_ANSI, 0, 0);
+}
 
-    if(ret != 0) {
-        free(buf.data);
-        napi_throw_error(env, NULL, "Markdown parsing failed");
-        return NULL;
-    }
+static napi_value md4x_napi_to_ansi_meta(napi_env env, napi_callback_info info)
+{
+    return render_impl(env, info, MD_RENDER_ANSI, MD_ANSI_FLAG_CODE_META, 1);
+}
 
-    napi_value result;
-    void* result_data;
-    napi_create_buffer_copy(env, buf.size, buf.data ? buf.data : "", &result_data, &result);
-    free(buf.data);
-    return result;
+static napi_value md4x_napi_to_meta(napi_env env, napi_callback_info info)
+{
+    return render_impl(env, info, MD_RENDER_META, 0, 0);
 }
 
-static napi_value md4x_napi_to_ast(napi_env env, napi_callback_info info)
+static napi_value md4x_napi_to_text(napi_env env, napi_callback_info info)
 {
-    return render_impl(env, info, md_ast);
+    return render_impl(env, info, MD_RENDER_TEXT, 0, 0);
 }
 
-static napi_value md4x_napi_to_ansi(napi_env env, napi_callback_info info)
+static napi_value md4x_napi_to_markdown(napi_env env, napi_callback_info info)
 {
-    return render_impl(env, info, md_ansi);
+    return render_impl(env, info, MD_RENDER_MARKDOWN, 0, 0);
 }
 
-static napi_value md4x_napi_to_ansi_meta(napi_env env, napi_callback_info info)
+
+/* heal(input, limits): healing does not parse, so only the max_output_bytes
+ * limit applies, to the healed output. */
+static napi_value md4x_napi_heal(napi_env env, napi_callback_info info)
 {
-    size_t argc = 1;
-    napi_value argv[1];
+    size_t argc = 2;
+    napi_value argv[2];
+    MD_LIMITS limits;
+    int with_limits = 0;
     napi_get_cb_info(env, info, &argc, argv, NULL, NULL);
 
     if(argc < 1) {
@@ -232,51 +248,85 @@ static napi_value md4x_napi_to_ansi_meta(napi_env env, napi_callback_info info)
     }
     napi_get_value_string_utf8(env, argv[0], input, input_size + 1, &input_size);
 
+    if(argc >= 2)
+        with_limits = get_limits(env, argv[1], &limits);
+
     napi_buf buf = { NULL, 0, 0, 0 };
-    int ret = md_ansi(input, (unsigned) input_size, napi_buf_append, &buf,
-                      MD_DIALECT_ALL, MD_ANSI_FLAG_CODE_META);
+    int ret = md_heal(input, (MD_SIZE) input_size, napi_buf_append, &buf);
     free(input);
+    if(ret == 0 && buf.error)
+        ret = -1;
+    if(ret == 0 && with_limits && limits.max_output_bytes > 0 &&
+       buf.size > limits.max_output_bytes)
+        ret = MD_LIMIT_EXCEEDED;
 
-    if(ret != 0 || buf.error) {
+    if(ret != 0) {
         free(buf.data);
-        napi_throw_error(env, NULL, "Markdown parsing failed");
+        throw_render_error(env, ret, "Markdown heal failed");
         return NULL;
     }
 
     napi_value result;
-    void* result_data;
-    napi_create_buffer_copy(env, buf.size, buf.data ? buf.data : "", &result_data, &result);
+    napi_create_string_utf8(env, buf.data ? buf.data : "", buf.size, &result);
     free(buf.data);
     return result;
 }
 
-static napi_value md4x_napi_to_meta(napi_env env, napi_callback_info info)
-{
-    return render_impl(env, info, md_meta);
-}
 
-static napi_value md4x_napi_to_text(napi_env env, napi_callback_info info)
-{
-    return render_impl(env, info, md_text);
-}
+/* renderAll() flag: also collect parser statistics. */
+#define MD4X_RENDER_ALL_STATS 0x10000
 
-static napi_value md4x_napi_to_markdown(napi_env env, napi_callback_info info)
+/* renderAll(input, formats, flags, limits): one parse, several outputs.
+ * Bit N of formats selects MD_RENDER_FORMAT N; returns an array of strings
+ * in format order. flags is a bitmask of MD_MULTI_FLAG_xxxx; with
+ * MD4X_RENDER_ALL_STATS, the MD_PARSE_STATS fields (in declaration order)
+ * are appended to the array as an array of numbers. The optional limits is
+ * an array of the MD_LIMITS fields (in declaration order, 0 = unlimited);
+ * exceeding them throws an error with code "MD4X_LIMIT_EXCEEDED". */
+static napi_value md4x_napi_render_all(napi_env env, napi_callback_info info)
 {
-    return render_impl(env, info, md_markdown);
-}
-
-
-static napi_value md4x_napi_heal(napi_env env, napi_callback_info info)
-{
-    size_t argc = 1;
-    napi_value argv[1];
+    size_t argc = 4;
+    napi_value argv[4];
     napi_get_cb_info(env, info, &argc, argv, NULL, NULL);
 
-    if(argc < 1) {
-        napi_throw_error(env, NULL, "Expected 1 argument");
+    if(argc < 2) {
+        napi_throw_error(env, NULL, "Expected 2 arguments");
         return NULL;
     }
 
+    uint32_t formats = 0;
+    if(napi_get_value_uint32(env, argv[1], &formats) != napi_ok) {
+        napi_throw_type_error(env, NULL, "Expected formats bitmask");
+        return NULL;
+    }
+
+    unsigned flags = 0;
+    if(argc >= 3) {
+        uint32_t f;
+        if(napi_get_value_uint32(env, argv[2], &f) == napi_ok) {
+            flags = f;
+        }
+    }
+
+    MD_LIMITS limits;
+    int with_limits = 0;
+    if(argc >= 4)
+        with_limits = get_limits(env, argv[3], &limits);
+
+    MD_RENDER_TARGET targets[MD_MULTI_MAX_TARGETS];
+    napi_buf bufs[MD_MULTI_MAX_TARGETS];
+    int n = 0;
+    int i;
+    memset(bufs, 0, sizeof(bufs));
+    for(i = 0; i <= MD_RENDER_MARKDOWN; i++) {
+        if(!(formats & (1u << i))) continue;
+        targets[n].format = (MD_RENDER_FORMAT) i;
+        targets[n].renderer_flags = 0;
+        targets[n].process_output = napi_buf_append;
+        targets[n].userdata = &bufs[n];
+        n++;
+    }
+
     size_t input_size;
     napi_get_value_string_utf8(env, argv[0], NULL, 0, &input_size);
     char* input = (char*) malloc(input_size + 1);
@@ -286,19 +336,50 @@ static napi_value md4x_napi_heal(napi_env env, napi_callback_info info)
     }
     napi_get_value_string_utf8(env, argv[0], input, input_size + 1, &input_size);
 
-    napi_buf buf = { NULL, 0, 0, 0 };
-    int ret = md_heal(input, (unsigned) input_size, napi_buf_append, &buf);
+    MD_PARSE_STATS stats;
+    int with_stats = (flags & MD4X_RENDER_ALL_STATS) != 0;
+    int ret = md_render_multi(input, (MD_SIZE) input_size, targets, n,
+                              MD_DIALECT_ALL, flags & ~MD4X_RENDER_ALL_STATS,
+                              with_limits ? &limits : NULL, with_stats ? &stats : NULL);
     free(input);
+    for(i = 0; i < n; i++) {
+        if(bufs[i].error) ret = -1;
+    }
 
-    if(ret != 0 || buf.error) {
-        free(buf.data);
-        napi_throw_error(env, NULL, "Markdown heal failed");
+    napi_value result = NULL;
+    if(ret == 0) {
+        napi_create_array_with_length(env, (size_t) n + (with_stats ? 1 : 0), &result);
+        for(i = 0; i < n; i++) {
+            napi_value str;
+            napi_create_string_utf8(env, bufs[i].data ? bufs[i].data : "", bufs[i].size, &str);
+            napi_set_element(env, result, (uint32_t) i, str);
+        }
+        if(with_stats) {
+            double values[] = {
+                stats.n_lines, stats.n_blocks, stats.n_containers, stats.n_marks,
+                stats.n_rollbacks, stats.n_ref_defs, stats.n_reallocs,
+                (double) stats.peak_block_bytes, (double) stats.peak_container_bytes,
+                (double) stats.peak_mark_bytes, (double) stats.peak_buffer_bytes,
+                (double) stats.block_ns, (double) stats.ref_def_ns, (double) stats.mark_ns,
+                (double) stats.resolve_ns, (double) stats.emit_ns
+            };
+            napi_value arr;
+            napi_create_array_with_length(env, sizeof(values) / sizeof(values[0]), &arr);
+            for(i = 0; i < (int) (sizeof(values) / sizeof(values[0])); i++) {
+                napi_value num;
+                napi_create_double(env, values[i], &num);
+                napi_set_element(env, arr, (uint32_t) i, num);
+            }
+            napi_set_element(env, result, (uint32_t) n, arr);
+        }
+    }
+    for(i = 0; i < n; i++) {
+        free(bufs[i].data);
+    }
+    if(ret != 0) {
+        throw_render_error(env, ret, "Markdown parsing failed");
         return NULL;
     }
-
-    napi_value result;
-    napi_create_string_utf8(env, buf.data ? buf.data : "", buf.size, &result);
-    free(buf.data);
     return result;
 }
 
@@ -309,6 +390,7 @@ static napi_value init(napi_env env, napi_value exports)
     napi_property_descriptor props[] = {
         { "renderToHtml", NULL, md4x_napi_to_html, NULL, NULL, NULL, napi_default, NULL },
         { "renderToHtmlMeta", NULL, md4x_napi_to_html_meta, NULL, NULL, NULL, napi_default, NULL },
+        { "renderToHtmlBlocks", NULL, md4x_napi_to_html_blocks, NULL, NULL, NULL, napi_default, NULL },
         { "renderToAST", NULL, md4x_napi_to_ast, NULL, NULL, NULL, napi_default, NULL },
         { "renderToAnsi", NULL, md4x_napi_to_ansi, NULL, NULL, NULL, napi_default, NULL },
         { "renderToAnsiMeta", NULL, md4x_napi_to_ansi_meta, NULL, NULL, NULL, napi_default, NULL },
@@ -316,8 +398,9 @@ static napi_value init(napi_env env, napi_value exports)
         { "renderToText", NULL, md4x_napi_to_text, NULL, NULL, NULL, napi_default, NULL },
         { "renderToMarkdown", NULL, md4x_napi_to_markdown, NULL, NULL, NULL, napi_default, NULL },
         { "heal", NULL, md4x_napi_heal, NULL, NULL, NULL, napi_default, NULL },
+        { "renderAll", NULL, md4x_napi_render_all, NULL, NULL, NULL, napi_default, NULL },
     };
-    napi_define_properties(env, exports, 9, props);
+    napi_define_properties(env, exports, 11, props);
     return exports;
 }
 
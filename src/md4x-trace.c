@@ -0,0 +1,127 @@
+/*
+ * MD4X: Markdown parser for C
+ * (http://github.com/unjs/md4x)
+ *
+ * Copyright (c) 2026 Pooya Parsa <pooya@pi0.io>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "md4x-trace.h"
+
+#ifdef MD4X_TRACE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+
+typedef struct MD_TRACE_EVENT {
+    const char* name;
+    const char* arg_name;
+    unsigned long long ts;      /* Nanoseconds, monotonic clock. */
+    unsigned arg;
+    unsigned tid;
+    char phase;
+} MD_TRACE_EVENT;
+
+static MD_TRACE_EVENT trace_events[MD_TRACE_MAX_EVENTS];
+static unsigned long long trace_head = 0;  /* Total number of events recorded. */
+static unsigned trace_n_threads = 0;
+static __thread unsigned trace_tid = 0;
+
+
+static unsigned long long
+md_trace_clock(void)
+{
+    struct timespec ts;
+
+#ifdef _WIN32
+    timespec_get(&ts, TIME_UTC);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return (unsigned long long) ts.tv_sec * 1000000000ULL + (unsigned long long) ts.tv_nsec;
+}
+
+void
+md_trace_event(const char* name, char phase, const char* arg_name, unsigned arg)
+{
+    unsigned long long i;
+    MD_TRACE_EVENT* ev;
+
+    /* Threads (e.g. of the CLI --batch mode) get their own track. */
+    if(trace_tid == 0)
+        trace_tid = __atomic_add_fetch(&trace_n_threads, 1, __ATOMIC_RELAXED);
+
+    i = __atomic_fetch_add(&trace_head, 1, __ATOMIC_RELAXED);
+    ev = &trace_events[i % MD_TRACE_MAX_EVENTS];
+    ev->name = name;
+    ev->arg_name = arg_name;
+    ev->ts = md_trace_clock();
+    ev->arg = arg;
+    ev->tid = trace_tid;
+    ev->phase = phase;
+}
+
+int
+md_trace_dump(const char* path)
+{
+    unsigned long long head = __atomic_load_n(&trace_head, __ATOMIC_ACQUIRE);
+    unsigned long long i = (head > MD_TRACE_MAX_EVENTS) ? head - MD_TRACE_MAX_EVENTS : 0;
+    unsigned long long j, t0;
+    FILE* f;
+    int first = 1;
+
+    f = fopen(path, "w");
+    if(f == NULL)
+        return -1;
+
+    /* Timestamps are written in microseconds since the oldest event. */
+    t0 = ~0ULL;
+    for(j = i; j < head; j++) {
+        if(trace_events[j % MD_TRACE_MAX_EVENTS].ts < t0)
+            t0 = trace_events[j % MD_TRACE_MAX_EVENTS].ts;
+    }
+    fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for(; i < head; i++) {
+        const MD_TRACE_EVENT* ev = &trace_events[i % MD_TRACE_MAX_EVENTS];
+
+        fprintf(f, "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u",
+                first ? "" : ",", ev->name, ev->phase,
+                (double) (ev->ts - t0) / 1000.0, ev->tid);
+        if(ev->arg_name != NULL)
+            fprintf(f, ",\"args\":{\"%s\":%u}", ev->arg_name, ev->arg);
+        fputc('}', f);
+        first = 0;
+    }
+    fprintf(f, "\n]}\n");
+
+    trace_head = 0;
+    if(fclose(f) != 0)
+        return -1;
+    return 0;
+}
+
+#else
+
+/* ISO C forbids an empty translation unit. */
+typedef int md_trace_disabled;
+
+#endif /* MD4X_TRACE */
@@ -0,0 +1,70 @@
+/*
+ * MD4X: Markdown parser for C
+ * (http://github.com/unjs/md4x)
+ *
+ * Copyright (c) 2026 Pooya Parsa <pooya@pi0.io>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MD4X_TRACE_H
+#define MD4X_TRACE_H
+
+/* Trace instrumentation (build with -DMD4X_TRACE, `zig build -Dtrace=true`).
+ *
+ * The parser phases and the renderer callbacks record timestamped begin/end
+ * events into a process-wide ring buffer, which md_trace_dump() writes as a
+ * Chrome trace (JSON), viewable in chrome://tracing or https://ui.perfetto.dev.
+ * Without MD4X_TRACE, the MD_TRACE_xxx macros compile to nothing.
+ */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Capacity of the ring buffer. Older events are overwritten. */
+#define MD_TRACE_MAX_EVENTS (1 << 20)
+
+#ifdef MD4X_TRACE
+
+    /* Record an event. phase is 'B' (begin) or 'E' (end); arg_name (may be
+     * NULL) and arg describe a begin event, e.g. the block type. name and
+     * arg_name must be string literals (they are stored as pointers). */
+    void md_trace_event(const char *name, char phase, const char *arg_name, unsigned arg);
+
+    /* Write the recorded events to path as Chrome trace JSON and clear them.
+     * Returns 0 on success, -1 on error. */
+    int md_trace_dump(const char *path);
+
+#define MD_TRACE_BEGIN(name, arg_name, arg) md_trace_event((name), 'B', (arg_name), (unsigned) (arg))
+#define MD_TRACE_END(name)                  md_trace_event((name), 'E', NULL, 0)
+
+#else
+
+#define MD_TRACE_BEGIN(name, arg_name, arg) do {} while(0)
+#define MD_TRACE_END(name)                  do {} while(0)
+
+#endif
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+
+#endif /* MD4X_TRACE_H */
@@ -23,6 +23,8 @@
  * IN THE SOFTWARE.
  */
 
+#include <limits.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "md4x.h"
@@ -33,6 +35,7 @@
 #include "md4x-text.h"
 #include "md4x-markdown.h"
 #include "md4x-heal.h"
+#include "md4x-multi.h"
 
 
 /* Stub main for wasi libc (we are a library, not a program) */
@@ -40,13 +43,13 @@ int main(void) { return 0; }
 
 /* Result storage (global — WASM is single-threaded) */
 static char* g_result_data = NULL;
-static unsigned g_result_size = 0;
+static MD_SIZE g_result_size = 0;
 
 /* Growable output buffer */
 typedef struct {
     char* data;
-    unsigned size;
-    unsigned cap;
+    MD_SIZE size;
+    MD_SIZE cap;
     int error;
 } md4x_buf;
 
@@ -55,7 +58,7 @@ static void buf_append(const MD_CHAR* text, MD_SIZE size, void* userdata)
     md4x_buf* buf = (md4x_buf*) userdata;
     if(buf->error) return;
     if(buf->size + size > buf->cap) {
-        unsigned new_cap = buf->cap + buf->cap / 2 + size + 256;
+        MD_SIZE new_cap = buf->cap + buf->cap / 2 + size + 256;
         char* p = (char*) realloc(buf->data, new_cap);
         if(!p) { buf->error = 1; return; }
         buf->data = p;
@@ -92,26 +95,62 @@ unsigned md4x_result_ptr(void)
 __attribute__((export_name("md4x_result_size")))
 unsigned md4x_result_size(void)
 {
-    return g_result_size;
+    /* The WASM memory is 32-bit, so is the size even with MD4X_WIDE_OFFSETS. */
+    return (unsigned) g_result_size;
 }
 
 
-/* Renderer wrappers */
+/* A JS number as an MD_LIMITS field of the given maximum (0 = unlimited). */
+static unsigned long long limit_value(double v, unsigned long long max)
+{
+    if(!(v > 0)) return 0;
+    if(v >= (double) max) return max;
+    return (unsigned long long) v;
+}
+
+/* The limits arguments of the exports: the MD_LIMITS fields, 0 = unlimited.
+ * The two wider ones come as JS numbers and are clamped to their C type. */
+#define MD4X_LIMITS_PARAMS                                                   \
+    unsigned max_depth, unsigned max_marks, unsigned max_blocks,             \
+    double max_output_bytes, double max_steps
+
+/* Fill limits from MD4X_LIMITS_PARAMS; NULL if all of them are unlimited. */
+#define MD4X_LIMITS_FILL(limits)                                             \
+    md4x_limits(&(limits), max_depth, max_marks, max_blocks,                 \
+                max_output_bytes, max_steps)
+
+static const MD_LIMITS* md4x_limits(MD_LIMITS* limits, MD4X_LIMITS_PARAMS)
+{
+    limits->max_depth = max_depth;
+    limits->max_marks = max_marks;
+    limits->max_blocks = max_blocks;
+    limits->max_output_bytes = (unsigned long) limit_value(max_output_bytes, ULONG_MAX);
+    limits->max_steps = limit_value(max_steps, ULLONG_MAX);
+    if(limits->max_depth == 0 && limits->max_marks == 0 && limits->max_blocks == 0 &&
+       limits->max_output_bytes == 0 && limits->max_steps == 0)
+        return NULL;
+    return limits;
+}
+
 
-typedef int (*md4x_render_fn)(const MD_CHAR*, MD_SIZE,
-    void (*)(const MD_CHAR*, MD_SIZE, void*), void*, unsigned, unsigned);
+/* Renderer wrappers */
 
-static int render(md4x_render_fn fn, const char* input, unsigned input_size,
-                  unsigned renderer_flags)
+/* Render one format; renderer_flags may include the HEAL flag. Returns 0,
+ * -1 on error or MD_LIMIT_EXCEEDED. */
+static int render(MD_RENDER_FORMAT format, const char* input, unsigned input_size,
+                  unsigned renderer_flags, const MD_LIMITS* limits)
 {
     md4x_buf buf = { NULL, 0, 0, 0 };
-    int ret = fn(input, input_size, buf_append, &buf,
-                 MD_DIALECT_ALL, renderer_flags);
-    if(ret != 0 || buf.error) {
+    MD_RENDER_TARGET target = { format, renderer_flags, buf_append, &buf };
+    int ret = md_render_multi(input, input_size, &target, 1, MD_DIALECT_ALL,
+                              renderer_flags & MD_MULTI_FLAG_HEAL, limits, NULL);
+    if(ret == 0 && buf.error)
+        ret = -1;
+    if(ret != 0) {
         free(buf.data);
         g_result_data = NULL;
         g_result_size = 0;
-        return -1;
+        return ret;
     }
     /* Caller (JS) frees previous g_result_data via md4x_free(md4x_result_ptr()). */
     g_result_data = buf.data;
@@ -121,93 +160,187 @@ static int render(md4x_render_fn fn, const char* input, unsigned input_size,
 
 __attribute__((export_name("md4x_to_html")))
 int md4x_to_html(const char* input, unsigned input_size,
-                 unsigned renderer_flags)
+                 unsigned renderer_flags, MD4X_LIMITS_PARAMS)
 {
-    return render(md_html, input, input_size, renderer_flags);
+    MD_LIMITS limits;
+    return render(MD_RENDER_HTML, input, input_size, renderer_flags,
+                  MD4X_LIMITS_FILL(limits));
 }
 
 __attribute__((export_name("md4x_to_html_meta")))
-int md4x_to_html_meta(const char* input, unsigned input_size)
+int md4x_to_html_meta(const char* input, unsigned input_size,
+                      unsigned renderer_flags, MD4X_LIMITS_PARAMS)
 {
-    md4x_buf buf = { NULL, 0, 0, 0 };
-    int ret = md_html(input, input_size, buf_append, &buf,
-                      MD_DIALECT_ALL, MD_HTML_FLAG_CODE_META);
-    if(ret != 0 || buf.error) {
-        free(buf.data);
-        g_result_data = NULL;
-        g_result_size = 0;
-        return -1;
-    }
-    g_result_data = buf.data;
-    g_result_size = buf.size;
-    return 0;
+    MD_LIMITS limits;
+    return render(MD_RENDER_HTML, input, input_size,
+                  renderer_flags | MD_HTML_FLAG_CODE_META, MD4X_LIMITS_FILL(limits));
+}
+
+__attribute__((export_name("md4x_to_html_blocks")))
+int md4x_to_html_blocks(const char* input, unsigned input_size,
+                        unsigned renderer_flags, MD4X_LIMITS_PARAMS)
+{
+    MD_LIMITS limits;
+    return render(MD_RENDER_HTML, input, input_size,
+                  renderer_flags | MD_HTML_FLAG_BLOCK_META, MD4X_LIMITS_FILL(limits));
 }
 
 __attribute__((export_name("md4x_to_ast")))
 int md4x_to_ast(const char* input, unsigned input_size,
-                unsigned renderer_flags)
+                unsigned renderer_flags, MD4X_LIMITS_PARAMS)
 {
-    return render(md_ast, input, input_size, renderer_flags);
+    MD_LIMITS limits;
+    return render(MD_RENDER_AST, input, input_size, renderer_flags,
+                  MD4X_LIMITS_FILL(limits));
 }
 
 __attribute__((export_name("md4x_to_ansi")))
 int md4x_to_ansi(const char* input, unsigned input_size,
-                 unsigned renderer_flags)
+                 unsigned renderer_flags, MD4X_LIMITS_PARAMS)
 {
-    return render(md_ansi, input, input_size, renderer_flags);
+    MD_LIMITS limits;
+    return render(MD_RENDER_ANSI, input, input_size, renderer_flags,
+                  MD4X_LIMITS_FILL(limits));
 }
 
 __attribute__((export_name("md4x_to_ansi_meta")))
-int md4x_to_ansi_meta(const char* input, unsigned input_size)
+int md4x_to_ansi_meta(const char* input, unsigned input_size,
+                      unsigned renderer_flags, MD4X_LIMITS_PARAMS)
 {
-    md4x_buf buf = { NULL, 0, 0, 0 };
-    int ret = md_ansi(input, input_size, buf_append, &buf,
-                      MD_DIALECT_ALL, MD_ANSI_FLAG_CODE_META);
-    if(ret != 0 || buf.error) {
-        free(buf.data);
-        g_result_data = NULL;
-        g_result_size = 0;
-        return -1;
-    }
-    g_result_data = buf.data;
-    g_result_size = buf.size;
-    return 0;
+    MD_LIMITS limits;
+    return render(MD_RENDER_ANSI, input, input_size,
+                  renderer_flags | MD_ANSI_FLAG_CODE_META, MD4X_LIMITS_FILL(limits));
 }
 
 __attribute__((export_name("md4x_to_meta")))
 int md4x_to_meta(const char* input, unsigned input_size,
-                 unsigned renderer_flags)
+                 unsigned renderer_flags, MD4X_LIMITS_PARAMS)
 {
-    return render(md_meta, input, input_size, renderer_flags);
+    MD_LIMITS limits;
+    return render(MD_RENDER_META, input, input_size, renderer_flags,
+                  MD4X_LIMITS_FILL(limits));
 }
 
 __attribute__((export_name("md4x_to_text")))
 int md4x_to_text(const char* input, unsigned input_size,
-                 unsigned renderer_flags)
+                 unsigned renderer_flags, MD4X_LIMITS_PARAMS)
 {
-    return render(md_text, input, input_size, renderer_flags);
+    MD_LIMITS limits;
+    return render(MD_RENDER_TEXT, input, input_size, renderer_flags,
+                  MD4X_LIMITS_FILL(limits));
 }
 
 __attribute__((export_name("md4x_to_markdown")))
 int md4x_to_markdown(const char* input, unsigned input_size,
-                     unsigned renderer_flags)
+                     unsigned renderer_flags, MD4X_LIMITS_PARAMS)
 {
-    return render(md_markdown, input, input_size, renderer_flags);
+    MD_LIMITS limits;
+    return render(MD_RENDER_MARKDOWN, input, input_size, renderer_flags,
+                  MD4X_LIMITS_FILL(limits));
 }
 
+/* Healing does not parse, so only max_output_bytes applies, to the healed
+ * output. */
 __attribute__((export_name("md4x_heal")))
-int md4x_heal(const char* input, unsigned input_size)
+int md4x_heal(const char* input, unsigned input_size, double max_output_bytes)
 {
     md4x_buf buf = { NULL, 0, 0, 0 };
+    unsigned long max_size = (unsigned long) limit_value(max_output_bytes, ULONG_MAX);
     int ret = md_heal(input, input_size, buf_append, &buf);
-    if(ret != 0 || buf.error) {
+    if(ret == 0 && buf.error)
+        ret = -1;
+    if(ret == 0 && max_size > 0 && buf.size > max_size)
+        ret = MD_LIMIT_EXCEEDED;
+    if(ret != 0) {
         free(buf.data);
         g_result_data = NULL;
         g_result_size = 0;
-        return -1;
+        return ret;
     }
     /* Caller (JS) frees previous g_result_data via md4x_free(md4x_result_ptr()). */
     g_result_data = buf.data;
     g_result_size = buf.size;
     return 0;
 }
+
+/* md4x_render_all() flag: also collect parser statistics. */
+#define MD4X_RENDER_ALL_STATS 0x10000
+
+/* One parse, several outputs. Bit N of formats selects MD_RENDER_FORMAT N.
+ * The result is a table of little-endian u32 output sizes (one per selected
+ * format, in format order) followed by the concatenated outputs. With
+ * MD4X_RENDER_ALL_STATS, one more output holds the MD_PARSE_STATS fields (in
+ * declaration order) as a JSON array. Exceeding the limits returns
+ * MD_LIMIT_EXCEEDED, as for the single-format exports. */
+__attribute__((export_name("md4x_render_all")))
+int md4x_render_all(const char* input, unsigned input_size,
+                    unsigned formats, unsigned flags, MD4X_LIMITS_PARAMS)
+{
+    MD_LIMITS limits;
+    MD_RENDER_TARGET targets[MD_MULTI_MAX_TARGETS];
+    md4x_buf bufs[MD_MULTI_MAX_TARGETS + 1];
+    MD_PARSE_STATS stats;
+    int with_stats = (flags & MD4X_RENDER_ALL_STATS) != 0;
+    MD_SIZE total;
+    char* out;
+    int n = 0;
+    int i, ret;
+
+    memset(bufs, 0, sizeof(bufs));
+    for(i = 0; i <= MD_RENDER_MARKDOWN; i++) {
+        if(!(formats & (1u << i))) continue;
+        targets[n].format = (MD_RENDER_FORMAT) i;
+        targets[n].renderer_flags = 0;
+        targets[n].process_output = buf_append;
+        targets[n].userdata = &bufs[n];
+        n++;
+    }
+
+    ret = md_render_multi(input, input_size, targets, n, MD_DIALECT_ALL,
+                          flags & ~MD4X_RENDER_ALL_STATS, MD4X_LIMITS_FILL(limits),
+                          with_stats ? &stats : NULL);
+
+    if(ret == 0  &&  with_stats) {
+        char json[512];
+        int len = snprintf(json, sizeof(json),
+                "[%u,%u,%u,%u,%u,%u,%u,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu]",
+                stats.n_lines, stats.n_blocks, stats.n_containers, stats.n_marks,
+                stats.n_rollbacks, stats.n_ref_defs, stats.n_reallocs,
+                (unsigned long long) stats.peak_block_bytes,
+                (unsigned long long) stats.peak_container_bytes,
+                (unsigned long long) stats.peak_mark_bytes,
+                (unsigned long long) stats.peak_buffer_bytes,
+                stats.block_ns, stats.ref_def_ns, stats.mark_ns,
+                stats.resolve_ns, stats.emit_ns);
+        buf_append(json, (MD_SIZE) len, &bufs[n]);
+        n++;
+    }
+
+    total = 4 * (unsigned) n;
+    for(i = 0; i < n; i++) {
+        if(bufs[i].error) ret = -1;
+        total += bufs[i].size;
+    }
+    out = (ret == 0) ? (char*) malloc(total > 0 ? total : 1) : NULL;
+    if(out != NULL) {
+        MD_SIZE pos = 4 * (unsigned) n;
+        for(i = 0; i < n; i++) {
+            unsigned size = (unsigned) bufs[i].size;
+            memcpy(out + 4 * i, &size, 4);
+            if(bufs[i].size > 0)
+                memcpy(out + pos, bufs[i].data, bufs[i].size);
+            pos += bufs[i].size;
+        }
+    }
+    for(i = 0; i < n; i++) {
+        free(bufs[i].data);
+    }
+    if(out == NULL) {
+        g_result_data = NULL;
+        g_result_size = 0;
+        return (ret == MD_LIMIT_EXCEEDED) ? ret : -1;
+    }
+    g_result_data = out;
+    g_result_size = total;
+    return 0;
+}
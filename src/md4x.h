@@ -26,6 +26,8 @@
 #ifndef MD4X_H
 #define MD4X_H
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -45,8 +47,17 @@ extern "C"
 typedef char MD_CHAR;
 #endif
 
+/* Sizes and offsets are 32-bit unless MD4X_WIDE_OFFSETS is defined, which
+ * allows documents (and rendered outputs) larger than 4 GiB. As with
+ * MD4X_USE_UTF16, the macro has to be defined both when building MD4X and
+ * when including this header. */
+#ifdef MD4X_WIDE_OFFSETS
+    typedef unsigned long long MD_SIZE;
+    typedef unsigned long long MD_OFFSET;
+#else
     typedef unsigned MD_SIZE;
     typedef unsigned MD_OFFSET;
+#endif
 
     /* Block represents a part of document hierarchy structure like a paragraph
      * or list item.
@@ -422,6 +433,7 @@ typedef char MD_CHAR;
 #define MD_FLAG_COMPONENTS 0x20000              /* Enable inline/block component syntax. */
 #define MD_FLAG_ATTRIBUTES 0x40000              /* Enable trailing {attrs} on inline elements. */
 #define MD_FLAG_ALERTS 0x80000                  /* Enable > [!TYPE] alert/admonition syntax. */
+#define MD_FLAG_HEADINGINLINESONLY 0x100000     /* Process inlines of headings only; paragraphs and tables are reported empty. */
 
 #define MD_FLAG_PERMISSIVEAUTOLINKS (MD_FLAG_PERMISSIVEEMAILAUTOLINKS | MD_FLAG_PERMISSIVEURLAUTOLINKS | MD_FLAG_PERMISSIVEWWWAUTOLINKS)
 #define MD_FLAG_NOHTML (MD_FLAG_NOHTMLBLOCKS | MD_FLAG_NOHTMLSPANS)
@@ -439,6 +451,27 @@ typedef char MD_CHAR;
 #define MD_DIALECT_GITHUB (MD_FLAG_PERMISSIVEAUTOLINKS | MD_FLAG_TABLES | MD_FLAG_STRIKETHROUGH | MD_FLAG_TASKLISTS | MD_FLAG_ALERTS)
 #define MD_DIALECT_ALL (MD_FLAG_PERMISSIVEAUTOLINKS | MD_FLAG_TABLES | MD_FLAG_STRIKETHROUGH | MD_FLAG_TASKLISTS | MD_FLAG_LATEXMATHSPANS | MD_FLAG_WIKILINKS | MD_FLAG_UNDERLINE | MD_FLAG_FRONTMATTER | MD_FLAG_COMPONENTS | MD_FLAG_ATTRIBUTES | MD_FLAG_ALERTS)
 
+    /* Resource budgets of a single md_parse_ex() call.
+     *
+     * Each member is a limit, zero meaning unlimited. When the document
+     * exceeds any of them, the parsing stops early and md_parse_ex() returns
+     * MD_LIMIT_EXCEEDED. Callbacks already called for the beginning of the
+     * document are not undone, so any partial output should be discarded.
+     */
+    typedef struct MD_LIMITS
+    {
+        unsigned max_depth;     /* Nesting of container blocks (block quotes, lists, list items, components, ...). */
+        unsigned max_marks;     /* Inline marks, summed over all leaf blocks. */
+        unsigned max_blocks;    /* Leaf and container blocks. */
+        unsigned long max_output_bytes; /* Size of all text passed to the text() callback. */
+        unsigned long long max_steps;   /* Work units: lines, blocks, marks and mark rollbacks. */
+    } MD_LIMITS;
+
+    /* Value returned by md_parse_ex() when one of its MD_LIMITS is exceeded.
+     * Callbacks should not return it.
+     */
+#define MD_LIMIT_EXCEEDED (-2)
+
     /* Parser structure.
      */
     typedef struct MD_PARSER
@@ -503,6 +536,51 @@ typedef char MD_CHAR;
      */
     int md_parse(const MD_CHAR *text, MD_SIZE size, const MD_PARSER *parser, void *userdata);
 
+    /* Statistics about a single md_parse_ex() call.
+     *
+     * Counts describe the whole document. Times are wall-clock nanoseconds
+     * spent in each parser phase; each nanosecond is accounted to exactly one
+     * phase, so they sum up to the whole parse.
+     */
+    typedef struct MD_PARSE_STATS
+    {
+        unsigned n_lines;       /* Lines analyzed by the block parser. */
+        unsigned n_blocks;      /* Leaf blocks (paragraphs, headings, code blocks, tables, ...). */
+        unsigned n_containers;  /* Container blocks (block quotes, lists, list items, components, ...). */
+        unsigned n_marks;       /* Inline marks collected, summed over all leaf blocks. */
+        unsigned n_inline_blocks; /* Leaf blocks and table cells with inline content. */
+        unsigned n_plain_blocks;  /* Of those, the ones without any mark character (no inline analysis). */
+        unsigned n_rollbacks;   /* Mark rollbacks while resolving links and emphasis. */
+        unsigned n_ref_defs;    /* Link reference definitions. */
+        unsigned n_reallocs;    /* Reallocations growing the internal buffers. */
+
+        /* Peak sizes (in bytes) of the internal buffers. */
+        size_t peak_block_bytes;        /* Block and line records. */
+        size_t peak_container_bytes;    /* Container stack. */
+        size_t peak_mark_bytes;         /* Inline marks of one leaf block. */
+        size_t peak_buffer_bytes;       /* Temporary buffer (e.g. link destinations). */
+
+        unsigned long long block_ns;    /* Line analysis and grouping lines into blocks. */
+        unsigned long long ref_def_ns;  /* Building the reference definition table. */
+        unsigned long long mark_ns;     /* Collecting inline marks. */
+        unsigned long long resolve_ns;  /* Resolving links, emphasis and attributes. */
+        unsigned long long emit_ns;     /* Emitting the document, including time in callbacks. */
+    } MD_PARSE_STATS;
+
+    /* Same as md_parse(), with two optional extras (either may be NULL):
+     *
+     * If 'limits' is not NULL, the parsing is bounded by it, e.g. for
+     * untrusted input, so that a hostile document cannot consume an unbounded
+     * amount of time or memory. MD_LIMIT_EXCEEDED is returned when a limit is
+     * exceeded.
+     *
+     * If 'stats' is not NULL, it is filled with statistics about the parsing.
+     * Collecting them has a small cost, so it should be NULL when they are
+     * not needed.
+     */
+    int md_parse_ex(const MD_CHAR *text, MD_SIZE size, const MD_PARSER *parser, void *userdata,
+                    const MD_LIMITS *limits, MD_PARSE_STATS *stats);
+
 #ifdef __cplusplus
 } /* extern "C" { */
 #endif
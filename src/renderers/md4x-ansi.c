@@ -29,6 +29,7 @@
 #include "md4x-ansi.h"
 #include "md4x-props.h"
 #include "md4x-heal-wrap.h"
+#include "md4x-render.h"
 #include "entity.h"
 
 
@@ -430,8 +431,8 @@ render_ansi_code_meta_json(MD_ANSI* r)
         MD_ANSI_CODE_META* m = &r->code_blocks[i];
         if(i > 0) out(",", 1, ud);
 
-        n = snprintf(buf, sizeof(buf), "{\"s\":%u,\"e\":%u",
-                     (unsigned)m->start, (unsigned)m->end);
+        n = snprintf(buf, sizeof(buf), "{\"s\":%llu,\"e\":%llu",
+                     (unsigned long long)m->start, (unsigned long long)m->end);
         out(buf, (MD_SIZE)n, ud);
 
         if(m->lang_size > 0) {
@@ -1019,6 +1020,44 @@ debug_log_callback(const char* msg, void* userdata)
         fprintf(stderr, "MD4X: %s\n", msg);
 }
 
+static void
+ansi_begin(void* ctx, MD_PARSER* parser,
+           void (*process_output)(const MD_CHAR*, MD_SIZE, void*),
+           void* userdata, unsigned renderer_flags)
+{
+    MD_ANSI* r = (MD_ANSI*) ctx;
+
+    memset(r, 0, sizeof(MD_ANSI));
+    r->process_output = process_output;
+    r->userdata = userdata;
+    r->flags = renderer_flags;
+
+    parser->enter_block = enter_block_callback;
+    parser->leave_block = leave_block_callback;
+    parser->enter_span = enter_span_callback;
+    parser->leave_span = leave_span_callback;
+    parser->text = text_callback;
+    parser->debug_log = debug_log_callback;
+}
+
+static int
+ansi_end(void* ctx, int ret)
+{
+    MD_ANSI* r = (MD_ANSI*) ctx;
+
+    if(r->flags & MD_ANSI_FLAG_CODE_META) {
+        if(ret == 0)
+            render_ansi_code_meta_json(r);
+        ansi_code_meta_cleanup(r);
+    }
+
+    return ret;
+}
+
+const MD_RENDER_HOOKS md_ansi_render_hooks = {
+    sizeof(MD_ANSI), ansi_begin, ansi_end
+};
+
 int
 md_ansi(const MD_CHAR* input, MD_SIZE input_size,
         void (*process_output)(const MD_CHAR*, MD_SIZE, void*),
@@ -1042,18 +1081,8 @@ md_ansi(const MD_CHAR* input, MD_SIZE input_size,
     }
 
     memset(&parser, 0, sizeof(parser));
+    ansi_begin(&render, &parser, process_output, userdata, renderer_flags);
     parser.flags = parser_flags;
-    parser.enter_block = enter_block_callback;
-    parser.leave_block = leave_block_callback;
-    parser.enter_span = enter_span_callback;
-    parser.leave_span = leave_span_callback;
-    parser.text = text_callback;
-    parser.debug_log = debug_log_callback;
-
-    memset(&render, 0, sizeof(render));
-    render.process_output = process_output;
-    render.userdata = userdata;
-    render.flags = renderer_flags;
 
     /* Consider skipping UTF-8 byte order mark (BOM). */
     if(renderer_flags & MD_ANSI_FLAG_SKIP_UTF8_BOM  &&  sizeof(MD_CHAR) == 1) {
@@ -1064,15 +1093,5 @@ md_ansi(const MD_CHAR* input, MD_SIZE input_size,
         }
     }
 
-    {
-        int ret = md_parse(input, input_size, &parser, (void*) &render);
-
-        if(renderer_flags & MD_ANSI_FLAG_CODE_META) {
-            if(ret == 0)
-                render_ansi_code_meta_json(&render);
-            ansi_code_meta_cleanup(&render);
-        }
-
-        return ret;
-    }
+    return ansi_end(&render, md_parse(input, input_size, &parser, (void*) &render));
 }
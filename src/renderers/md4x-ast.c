@@ -30,6 +30,7 @@
 #include "md4x-props.h"
 #include "md4x-json.h"
 #include "md4x-heal-wrap.h"
+#include "md4x-render.h"
 
 #define JSON_MAX_DEPTH  256
 
@@ -1137,13 +1138,60 @@ json_serialize_node(JSON_WRITER* w, const JSON_NODE* node)
  ***  Public API                    ***
  **************************************/
 
+/* Renderer context together with its output sink. JSON_CTX comes first so
+ * the md_parse() callbacks can treat a JSON_RENDER* as their JSON_CTX*. */
+typedef struct {
+    JSON_CTX ctx;
+    JSON_WRITER writer;
+} JSON_RENDER;
+
+static void
+ast_begin(void* ctx, MD_PARSER* parser,
+          void (*process_output)(const MD_CHAR*, MD_SIZE, void*),
+          void* userdata, unsigned renderer_flags)
+{
+    JSON_RENDER* r = (JSON_RENDER*) ctx;
+
+    memset(r, 0, sizeof(JSON_RENDER));
+    r->writer.process_output = process_output;
+    r->writer.userdata = userdata;
+
+    parser->enter_block = json_enter_block;
+    parser->leave_block = json_leave_block;
+    parser->enter_span = json_enter_span;
+    parser->leave_span = json_leave_span;
+    parser->text = json_text;
+    parser->debug_log = (renderer_flags & MD_AST_FLAG_DEBUG) ? json_debug_log : NULL;
+}
+
+static int
+ast_end(void* ctx, int ret)
+{
+    JSON_RENDER* r = (JSON_RENDER*) ctx;
+
+    if(ret != 0 || r->ctx.error != 0) {
+        json_node_free(r->ctx.root);
+        return -1;
+    }
+
+    /* Serialize the AST to JSON via the output callback. */
+    json_serialize_node(&r->writer, r->ctx.root);
+    json_write(&r->writer, "\n", 1);
+
+    json_node_free(r->ctx.root);
+    return 0;
+}
+
+const MD_RENDER_HOOKS md_ast_render_hooks = {
+    sizeof(JSON_RENDER), ast_begin, ast_end
+};
+
 int
 md_ast(const MD_CHAR* input, MD_SIZE input_size,
        void (*process_output)(const MD_CHAR*, MD_SIZE, void*),
        void* userdata, unsigned parser_flags, unsigned renderer_flags)
 {
-    JSON_CTX ctx;
-    JSON_WRITER writer;
+    JSON_RENDER render;
     MD_PARSER parser;
     int ret;
 
@@ -1161,16 +1209,8 @@ md_ast(const MD_CHAR* input, MD_SIZE input_size,
     }
 
     memset(&parser, 0, sizeof(parser));
-    parser.abi_version = 0;
+    ast_begin(&render, &parser, process_output, userdata, renderer_flags);
     parser.flags = parser_flags;
-    parser.enter_block = json_enter_block;
-    parser.leave_block = json_leave_block;
-    parser.enter_span = json_enter_span;
-    parser.leave_span = json_leave_span;
-    parser.text = json_text;
-    parser.debug_log = (renderer_flags & MD_AST_FLAG_DEBUG) ? json_debug_log : NULL;
-
-    memset(&ctx, 0, sizeof(ctx));
 
 #ifndef MD4X_USE_ASCII
     /* Skip UTF-8 BOM. */
@@ -1183,19 +1223,6 @@ md_ast(const MD_CHAR* input, MD_SIZE input_size,
     }
 #endif
 
-    ret = md_parse(input, input_size, &parser, (void*) &ctx);
-
-    if(ret != 0 || ctx.error != 0) {
-        json_node_free(ctx.root);
-        return -1;
-    }
-
-    /* Serialize the AST to JSON via the output callback. */
-    writer.process_output = process_output;
-    writer.userdata = userdata;
-    json_serialize_node(&writer, ctx.root);
-    json_write(&writer, "\n", 1);
-
-    json_node_free(ctx.root);
-    return 0;
+    ret = md_parse(input, input_size, &parser, (void*) &render);
+    return ast_end(&render, ret);
 }
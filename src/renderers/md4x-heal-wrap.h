@@ -19,19 +19,19 @@
 typedef struct
 {
     char *data;
-    unsigned size;
-    unsigned cap;
+    MD_SIZE size;
+    MD_SIZE cap;
     int error;
 } MD4X_HEAL_BUF;
 
 static void
-md4x_heal_buf_append(const char *text, unsigned size, void *userdata)
+md4x_heal_buf_append(const char *text, MD_SIZE size, void *userdata)
 {
     MD4X_HEAL_BUF *buf = (MD4X_HEAL_BUF *)userdata;
     if (buf->error) return;
     if (buf->size + size > buf->cap)
     {
-        unsigned new_cap = buf->cap + buf->cap / 2 + size + 256;
+        MD_SIZE new_cap = buf->cap + buf->cap / 2 + size + 256;
         char *p = (char *)realloc(buf->data, new_cap);
         if (!p) { buf->error = 1; return; }
         buf->data = p;
@@ -44,19 +44,27 @@
 #endif
 
 
+/* Signed position, for the scans walking backwards. */
+#ifdef MD4X_WIDE_OFFSETS
+typedef long long HEAL_SPOS;
+#else
+typedef int HEAL_SPOS;
+#endif
+
+
 /***************************
  ***  Growable buffer    ***
  ***************************/
 
 typedef struct {
     char* data;
-    unsigned size;
-    unsigned cap;
+    MD_SIZE size;
+    MD_SIZE cap;
     int error;
 } HEAL_BUF;
 
 static inline void
-buf_init(HEAL_BUF* buf, unsigned initial_cap)
+buf_init(HEAL_BUF* buf, MD_SIZE initial_cap)
 {
     buf->data = (char*) malloc(initial_cap);
     buf->size = 0;
@@ -65,11 +73,11 @@ buf_init(HEAL_BUF* buf, unsigned initial_cap)
 }
 
 static inline void
-buf_append(HEAL_BUF* buf, const char* s, unsigned len)
+buf_append(HEAL_BUF* buf, const char* s, MD_SIZE len)
 {
     if(len == 0 || buf->error) return;
     if(buf->size + len > buf->cap) {
-        unsigned new_cap = buf->cap + buf->cap / 2 + len + 64;
+        MD_SIZE new_cap = buf->cap + buf->cap / 2 + len + 64;
         char* p = (char*) realloc(buf->data, new_cap);
         if(!p) { buf->error = 1; return; }
         buf->data = p;
@@ -107,9 +115,9 @@ is_word_char(char c)
 }
 
 static inline int
-is_escaped(const char* text, unsigned pos)
+is_escaped(const char* text, MD_SIZE pos)
 {
-    unsigned n = 0;
+    MD_SIZE n = 0;
     while(pos > 0 && text[pos - 1] == '\\') {
         n++;
         pos--;
@@ -119,7 +127,7 @@ is_escaped(const char* text, unsigned pos)
 
 /* Check if position i is part of a ``` sequence */
 static inline int
-is_triple_backtick(const char* text, unsigned size, unsigned i)
+is_triple_backtick(const char* text, MD_SIZE size, MD_SIZE i)
 {
     /* Check if i is the start of ``` */
     if(i + 2 < size && text[i] == '`' && text[i+1] == '`' && text[i+2] == '`')
@@ -134,8 +142,8 @@ is_triple_backtick(const char* text, unsigned size, unsigned i)
 }
 
 /* Find the start of the current line (returns index after preceding newline) */
-static inline unsigned
-line_start(const char* text, unsigned pos)
+static inline MD_SIZE
+line_start(const char* text, MD_SIZE pos)
 {
     while(pos > 0 && text[pos - 1] != '\n')
         pos--;
@@ -143,8 +151,8 @@ line_start(const char* text, unsigned pos)
 }
 
 /* Find the end of the current line (returns index of newline or size) */
-static inline unsigned
-line_end(const char* text, unsigned size, unsigned pos)
+static inline MD_SIZE
+line_end(const char* text, MD_SIZE size, MD_SIZE pos)
 {
     while(pos < size && text[pos] != '\n')
         pos++;
@@ -153,12 +161,12 @@ line_end(const char* text, unsigned size, unsigned pos)
 
 /* Check if a line is a horizontal rule (3+ of same marker with only whitespace) */
 static inline int
-is_horizontal_rule(const char* text, unsigned size, unsigned marker_pos, char marker)
+is_horizontal_rule(const char* text, MD_SIZE size, MD_SIZE marker_pos, char marker)
 {
-    unsigned ls = line_start(text, marker_pos);
-    unsigned le = line_end(text, size, marker_pos);
-    unsigned count = 0;
-    unsigned i;
+    MD_SIZE ls = line_start(text, marker_pos);
+    MD_SIZE le = line_end(text, size, marker_pos);
+    MD_SIZE count = 0;
+    MD_SIZE i;
     for(i = ls; i < le; i++) {
         if(text[i] == marker) {
             count++;
@@ -174,13 +182,12 @@ is_horizontal_rule(const char* text, unsigned size, unsigned marker_pos, char ma
  ***  Context tracking   ***
  ***************************/
 
-/* Count triple-backtick fences up to a position to determine code block state */
+/* Continue a fence scan from *at up to pos, starting in the given state.
+ * Resuming is exact only from a line start (or from 0). */
 static int
-in_fenced_code_block(const char* text, unsigned size, unsigned pos)
+scan_fences(const char* text, MD_SIZE pos, MD_SIZE* at, int inside)
 {
-    int inside = 0;
-    unsigned i = 0;
-    (void) size;
+    MD_SIZE i = *at;
     while(i < pos) {
         if(text[i] == '`' && i + 2 < pos && text[i+1] == '`' && text[i+2] == '`') {
             if(!is_escaped(text, i))
@@ -192,15 +199,25 @@ in_fenced_code_block(const char* text, unsigned size, unsigned pos)
             i++;
         }
     }
+    *at = i;
     return inside;
 }
 
+/* Count triple-backtick fences up to a position to determine code block state */
+static int
+in_fenced_code_block(const char* text, MD_SIZE size, MD_SIZE pos)
+{
+    MD_SIZE at = 0;
+    (void) size;
+    return scan_fences(text, pos, &at, 0);
+}
+
 /* Count ``` sequences in the entire text */
-static unsigned
-count_fences(const char* text, unsigned size)
+static MD_SIZE
+count_fences(const char* text, MD_SIZE size)
 {
-    unsigned count = 0;
-    unsigned i = 0;
+    MD_SIZE count = 0;
+    MD_SIZE i = 0;
     while(i < size) {
         if(text[i] == '`' && i + 2 < size && text[i+1] == '`' && text[i+2] == '`') {
             if(!is_escaped(text, i))
@@ -215,11 +232,11 @@ count_fences(const char* text, unsigned size)
 }
 
 /* Count single backticks that are NOT part of ``` and NOT escaped */
-static unsigned
-count_single_backticks(const char* text, unsigned size)
+static MD_SIZE
+count_single_backticks(const char* text, MD_SIZE size)
 {
-    unsigned count = 0;
-    unsigned i;
+    MD_SIZE count = 0;
+    MD_SIZE i;
     for(i = 0; i < size; i++) {
         if(text[i] == '`' && !is_escaped(text, i) && !is_triple_backtick(text, size, i))
             count++;
@@ -229,11 +246,11 @@ count_single_backticks(const char* text, unsigned size)
 
 /* Check if position is inside a completed inline code span */
 static int
-in_complete_inline_code(const char* text, unsigned size, unsigned pos)
+in_complete_inline_code(const char* text, MD_SIZE size, MD_SIZE pos)
 {
-    unsigned i;
+    MD_SIZE i;
     int in_code = 0;
-    unsigned code_start = 0;
+    MD_SIZE code_start = 0;
     for(i = 0; i < size; i++) {
         if(text[i] == '`' && !is_escaped(text, i) && !is_triple_backtick(text, size, i)) {
             if(!in_code) {
@@ -250,62 +267,84 @@ in_complete_inline_code(const char* text, unsigned size, unsigned pos)
     return 0;
 }
 
+/* Position-dependent context for the delimiter counters below. Queries must
+ * come in increasing position order; each query only scans the text between
+ * the previous position and the new one, so that a counter stays linear in
+ * the text size. */
+typedef struct {
+    MD_SIZE math_pos;      /* Where the $...$ / $$...$$ scan stopped. */
+    int in_math_block;      /* Inside $$...$$ */
+    int in_math_inline;     /* Inside $...$ */
+    MD_SIZE pos;           /* Characters before pos have been seen. */
+    MD_SIZE paren_end;     /* 1 + index of the last '\n', '(' or ')' (0 = none) */
+    MD_SIZE angle_end;     /* 1 + index of the last '\n', '<' or '>' (0 = none) */
+} HEAL_SCAN;
+
+static inline void
+scan_init(HEAL_SCAN* scan)
+{
+    memset(scan, 0, sizeof(HEAL_SCAN));
+}
+
+static void
+scan_advance(HEAL_SCAN* scan, const char* text, MD_SIZE pos)
+{
+    for(; scan->pos < pos; scan->pos++) {
+        char c = text[scan->pos];
+        if(c == '\n' || c == '(' || c == ')')
+            scan->paren_end = scan->pos + 1;
+        if(c == '\n' || c == '<' || c == '>')
+            scan->angle_end = scan->pos + 1;
+    }
+}
+
 /* Check if position is inside $...$ or $$...$$ */
 static int
-in_math_block(const char* text, unsigned size, unsigned pos)
+in_math_block(HEAL_SCAN* scan, const char* text, MD_SIZE size, MD_SIZE pos)
 {
-    int in_block = 0;     /* inside $$ */
-    int in_inline = 0;    /* inside $ */
-    unsigned i;
-    for(i = 0; i < size && i < pos; i++) {
-        if(text[i] == '\\') { i++; continue; }
+    MD_SIZE i;
+    while(scan->math_pos < size && scan->math_pos < pos) {
+        i = scan->math_pos;
+        if(text[i] == '\\') { scan->math_pos = i + 2; continue; }
         if(text[i] == '$') {
             if(i + 1 < size && text[i+1] == '$') {
-                in_block = !in_block;
-                i++;
-            } else if(!in_block) {
-                in_inline = !in_inline;
+                scan->in_math_block = !scan->in_math_block;
+                scan->math_pos = i + 2;
+                continue;
+            } else if(!scan->in_math_block) {
+                scan->in_math_inline = !scan->in_math_inline;
             }
         }
+        scan->math_pos = i + 1;
     }
-    return in_block || in_inline;
+    return scan->in_math_block || scan->in_math_inline;
 }
 
-/* Check if position is inside a link/image URL: ](... */
+/* Check if position is inside a link/image URL: ](...
+ * (i.e. the nearest '\n', '(' or ')' before it is the '(' of "](") */
 static int
-in_link_url(const char* text, unsigned pos)
+in_link_url(HEAL_SCAN* scan, const char* text, MD_SIZE pos)
 {
-    unsigned i;
-    if(pos == 0) return 0;
-    for(i = pos; i > 0; i--) {
-        if(text[i - 1] == '\n') return 0;
-        if(text[i - 1] == ')') return 0;
-        if(text[i - 1] == '(') {
-            if(i >= 2 && text[i - 2] == ']')
-                return 1;
-            return 0;
-        }
-    }
-    return 0;
+    MD_SIZE k;
+    scan_advance(scan, text, pos);
+    k = scan->paren_end;
+    if(k == 0 || text[k - 1] != '(') return 0;
+    return (k >= 2 && text[k - 2] == ']');
 }
 
-/* Check if position is inside an HTML tag: <...> */
+/* Check if position is inside an HTML tag: <...>
+ * (i.e. the nearest '\n', '<' or '>' before it opens a tag) */
 static int
-in_html_tag(const char* text, unsigned pos)
+in_html_tag(HEAL_SCAN* scan, const char* text, MD_SIZE pos)
 {
-    unsigned i;
-    if(pos == 0) return 0;
-    for(i = pos; i > 0; i--) {
-        if(text[i - 1] == '\n') return 0;
-        if(text[i - 1] == '>') return 0;
-        if(text[i - 1] == '<') {
-            if(i < pos) {
-                char next = text[i];
-                return (next >= 'a' && next <= 'z') ||
-                       (next >= 'A' && next <= 'Z') || next == '/';
-            }
-            return 0;
-        }
+    MD_SIZE k;
+    scan_advance(scan, text, pos);
+    k = scan->angle_end;
+    if(k == 0 || text[k - 1] != '<') return 0;
+    if(k < pos) {
+        char next = text[k];
+        return (next >= 'a' && next <= 'z') ||
+               (next >= 'A' && next <= 'Z') || next == '/';
     }
     return 0;
 }
@@ -320,10 +359,10 @@ in_html_tag(const char* text, unsigned pos)
 static void
 heal_setext_heading(HEAL_BUF* buf)
 {
-    unsigned ls, le, i;
+    MD_SIZE ls, le, i;
     char marker;
     int count;
-    unsigned prev_le;
+    MD_SIZE prev_le;
 
     if(buf->size == 0) return;
 
@@ -365,7 +404,7 @@ heal_setext_heading(HEAL_BUF* buf)
 static void
 heal_code_block(HEAL_BUF* buf)
 {
-    unsigned fences = count_fences(buf->data, buf->size);
+    MD_SIZE fences = count_fences(buf->data, buf->size);
     if(fences % 2 != 0) {
         /* Need to close the code block */
         if(buf->size > 0 && buf->data[buf->size - 1] != '\n')
@@ -383,7 +422,7 @@ heal_code_block(HEAL_BUF* buf)
 static void
 heal_inline_code(HEAL_BUF* buf)
 {
-    unsigned fences, singles;
+    MD_SIZE fences, singles;
 
     /* Don't heal inside an unclosed fenced code block */
     fences = count_fences(buf->data, buf->size);
@@ -404,11 +443,11 @@ heal_inline_code(HEAL_BUF* buf)
  * These count delimiter sequences while tracking fenced code blocks inline. */
 
 /* Count ** pairs greedily (consumes 2 chars at a time), skipping code blocks */
-static unsigned
-count_double_asterisks(const char* text, unsigned size)
+static MD_SIZE
+count_double_asterisks(const char* text, MD_SIZE size)
 {
-    unsigned count = 0;
-    unsigned i;
+    MD_SIZE count = 0;
+    MD_SIZE i;
     int in_code = 0;
     for(i = 0; i < size; i++) {
         if(text[i] == '`' && i + 2 < size && text[i+1] == '`' && text[i+2] == '`') {
@@ -426,11 +465,11 @@ count_double_asterisks(const char* text, unsigned size)
 }
 
 /* Count __ pairs greedily, skipping code blocks */
-static unsigned
-count_double_underscores(const char* text, unsigned size)
+static MD_SIZE
+count_double_underscores(const char* text, MD_SIZE size)
 {
-    unsigned count = 0;
-    unsigned i;
+    MD_SIZE count = 0;
+    MD_SIZE i;
     int in_code = 0;
     for(i = 0; i < size; i++) {
         if(text[i] == '`' && i + 2 < size && text[i+1] == '`' && text[i+2] == '`') {
@@ -449,12 +488,12 @@ count_double_underscores(const char* text, unsigned size)
 
 /* Count *** triples, handling consecutive asterisk runs.
  * *** = 1, **** = 1, ***** = 1, ****** = 2, etc. */
-static unsigned
-count_triple_asterisks(const char* text, unsigned size)
+static MD_SIZE
+count_triple_asterisks(const char* text, MD_SIZE size)
 {
-    unsigned count = 0;
-    unsigned consecutive = 0;
-    unsigned i;
+    MD_SIZE count = 0;
+    MD_SIZE consecutive = 0;
+    MD_SIZE i;
     int in_code = 0;
     for(i = 0; i < size; i++) {
         if(text[i] == '`' && i + 2 < size && text[i+1] == '`' && text[i+2] == '`') {
@@ -481,12 +520,15 @@ count_triple_asterisks(const char* text, unsigned size)
  * - First * in *** counts as single (can close italic)
  * - First * in ** does NOT count
  * - Skip word-internal and whitespace-flanked */
-static unsigned
-count_single_asterisks(const char* text, unsigned size)
+static MD_SIZE
+count_single_asterisks(const char* text, MD_SIZE size)
 {
-    unsigned count = 0;
-    unsigned i;
+    MD_SIZE count = 0;
+    MD_SIZE i;
     int in_code = 0;
+    HEAL_SCAN scan;
+
+    scan_init(&scan);
     for(i = 0; i < size; i++) {
         if(text[i] == '`' && i + 2 < size && text[i+1] == '`' && text[i+2] == '`') {
             in_code = !in_code;
@@ -501,7 +543,7 @@ count_single_asterisks(const char* text, unsigned size)
             char next = (i + 1 < size) ? text[i + 1] : 0;
 
             if(prev == '\\') continue;
-            if(in_math_block(text, size, i)) continue;
+            if(in_math_block(&scan, text, size, i)) continue;
 
             /* Special handling for *** sequences */
             if(prev != '*' && next == '*') {
@@ -534,12 +576,15 @@ count_single_asterisks(const char* text, unsigned size)
 }
 
 /* Count single underscores (not part of __, not escaped, not word-internal) */
-static unsigned
-count_single_underscores(const char* text, unsigned size)
+static MD_SIZE
+count_single_underscores(const char* text, MD_SIZE size)
 {
-    unsigned count = 0;
-    unsigned i;
+    MD_SIZE count = 0;
+    MD_SIZE i;
     int in_code = 0;
+    HEAL_SCAN scan;
+
+    scan_init(&scan);
     for(i = 0; i < size; i++) {
         if(text[i] == '`' && i + 2 < size && text[i+1] == '`' && text[i+2] == '`') {
             in_code = !in_code;
@@ -554,9 +599,9 @@ count_single_underscores(const char* text, unsigned size)
             char next = (i + 1 < size) ? text[i + 1] : 0;
 
             if(prev == '\\') continue;
-            if(in_math_block(text, size, i)) continue;
-            if(in_link_url(text, i)) continue;
-            if(in_html_tag(text, i)) continue;
+            if(in_math_block(&scan, text, size, i)) continue;
+            if(in_link_url(&scan, text, i)) continue;
+            if(in_html_tag(&scan, text, i)) continue;
             if(prev == '_' || next == '_') continue;
             if(is_word_char(prev) && is_word_char(next)) continue;
         }
@@ -567,11 +612,11 @@ count_single_underscores(const char* text, unsigned size)
 }
 
 /* Count ~~ pairs, skipping code blocks */
-static unsigned
-count_double_tildes(const char* text, unsigned size)
+static MD_SIZE
+count_double_tildes(const char* text, MD_SIZE size)
 {
-    unsigned count = 0;
-    unsigned i;
+    MD_SIZE count = 0;
+    MD_SIZE i;
     int in_code = 0;
     for(i = 0; i < size; i++) {
         if(text[i] == '`' && i + 2 < size && text[i+1] == '`' && text[i+2] == '`') {
@@ -589,11 +634,11 @@ count_double_tildes(const char* text, unsigned size)
 }
 
 /* Count $$ pairs, skipping code blocks */
-static unsigned
-count_double_dollars(const char* text, unsigned size)
+static MD_SIZE
+count_double_dollars(const char* text, MD_SIZE size)
 {
-    unsigned count = 0;
-    unsigned i;
+    MD_SIZE count = 0;
+    MD_SIZE i;
     int in_code = 0;
     for(i = 0; i < size; i++) {
         if(text[i] == '`' && i + 2 < size && text[i+1] == '`' && text[i+2] == '`') {
@@ -611,15 +656,20 @@ count_double_dollars(const char* text, unsigned size)
 }
 
 
+static inline int
+is_meaningful_char(char c)
+{
+    return (c != ' ' && c != '\t' && c != '\n' && c != '\r' &&
+            c != '*' && c != '_' && c != '~' && c != '`');
+}
+
 /* Check if content between markers is meaningful (not just whitespace/markers) */
 static int
-has_meaningful_content(const char* text, unsigned start, unsigned end)
+has_meaningful_content(const char* text, MD_SIZE start, MD_SIZE end)
 {
-    unsigned i;
+    MD_SIZE i;
     for(i = start; i < end; i++) {
-        char c = text[i];
-        if(c != ' ' && c != '\t' && c != '\n' && c != '\r' &&
-           c != '*' && c != '_' && c != '~' && c != '`')
+        if(is_meaningful_char(text[i]))
             return 1;
     }
     return 0;
@@ -627,10 +677,10 @@ has_meaningful_content(const char* text, unsigned start, unsigned end)
 
 /* Match bold pattern at end of text: (**)(non-* text, optionally ending with *)$
  * Returns the index of the ** opener, or size if no match. */
-static unsigned
-match_bold_at_end(const char* text, unsigned size)
+static MD_SIZE
+match_bold_at_end(const char* text, MD_SIZE size)
 {
-    unsigned i;
+    MD_SIZE i;
     if(size < 3) return size;
 
     /* Scan backwards from end to find the last ** that's followed by non-* content */
@@ -642,7 +692,7 @@ match_bold_at_end(const char* text, unsigned size)
             if(text[i] == '*') continue;
             /* Verify remaining content (from i to end) has no ** (is non-star) */
             {
-                unsigned j;
+                MD_SIZE j;
                 int has_double_star = 0;
                 for(j = i; j + 1 < size; j++) {
                     if(text[j] == '*' && text[j+1] == '*') { has_double_star = 1; break; }
@@ -660,9 +710,9 @@ static void
 heal_bold(HEAL_BUF* buf)
 {
     const char* text = buf->data;
-    unsigned size = buf->size;
-    unsigned marker_pos;
-    unsigned pairs;
+    MD_SIZE size = buf->size;
+    MD_SIZE marker_pos;
+    MD_SIZE pairs;
 
     if(in_fenced_code_block(text, size, size)) return;
 
@@ -694,8 +744,8 @@ static void
 heal_italic_asterisk(HEAL_BUF* buf)
 {
     const char* text = buf->data;
-    unsigned size = buf->size;
-    unsigned singles;
+    MD_SIZE size = buf->size;
+    MD_SIZE singles;
 
     if(in_fenced_code_block(text, size, size)) return;
 
@@ -710,8 +760,8 @@ static void
 heal_italic_double_underscore(HEAL_BUF* buf)
 {
     const char* text = buf->data;
-    unsigned size = buf->size;
-    unsigned pairs;
+    MD_SIZE size = buf->size;
+    MD_SIZE pairs;
 
     if(in_fenced_code_block(text, size, size)) return;
 
@@ -736,15 +786,15 @@ static void
 heal_italic_underscore(HEAL_BUF* buf)
 {
     const char* text = buf->data;
-    unsigned size = buf->size;
-    unsigned singles;
+    MD_SIZE size = buf->size;
+    MD_SIZE singles;
 
     if(in_fenced_code_block(text, size, size)) return;
 
     singles = count_single_underscores(text, size);
     if(singles % 2 != 0) {
         /* Append before trailing newlines */
-        unsigned end = size;
+        MD_SIZE end = size;
         while(end > 0 && buf->data[end - 1] == '\n') end--;
 
         if(end < size) {
@@ -767,14 +817,14 @@ static void
 heal_bold_italic(HEAL_BUF* buf)
 {
     const char* text = buf->data;
-    unsigned size = buf->size;
-    unsigned triples;
+    MD_SIZE size = buf->size;
+    MD_SIZE triples;
 
     if(in_fenced_code_block(text, size, size)) return;
 
     /* Skip if text is all asterisks (e.g., ****) */
     {
-        unsigned i;
+        MD_SIZE i;
         int all_stars = 1;
         for(i = 0; i < size; i++) {
             if(text[i] != '*') { all_stars = 0; break; }
@@ -786,8 +836,8 @@ heal_bold_italic(HEAL_BUF* buf)
     if(triples % 2 != 0) {
         /* Check if ** and * are independently balanced
          * If so, *** is overlapping closers, not opening bold-italic */
-        unsigned doubles = count_double_asterisks(text, size);
-        unsigned singles = count_single_asterisks(text, size);
+        MD_SIZE doubles = count_double_asterisks(text, size);
+        MD_SIZE singles = count_single_asterisks(text, size);
         if(doubles % 2 == 0 && singles % 2 == 0) return;
         buf_append(buf, "***", 3);
     }
@@ -802,22 +852,24 @@ static void
 heal_strikethrough(HEAL_BUF* buf)
 {
     const char* text = buf->data;
-    unsigned size = buf->size;
-    unsigned pairs;
+    MD_SIZE size = buf->size;
+    MD_SIZE pairs;
 
     if(in_fenced_code_block(text, size, size)) return;
 
     /* Half-complete: ~~text~ at end -> ~~text~~ */
     if(size >= 4 && text[size - 1] == '~' &&
        text[size - 2] != '~' && text[size - 2] != '\\') {
-        unsigned i = size - 2;
+        MD_SIZE i = size - 2;
+        int meaningful = 0;     /* Anything meaningful in text[i+1 .. size-2] */
         while(i > 0) {
             if(text[i] == '~' && i > 0 && text[i-1] == '~') {
-                if(has_meaningful_content(text, i + 1, size - 1)) {
+                if(meaningful) {
                     buf_append_ch(buf, '~');
                     return;
                 }
             }
+            meaningful |= is_meaningful_char(text[i]);
             i--;
         }
     }
@@ -825,14 +877,16 @@ heal_strikethrough(HEAL_BUF* buf)
     pairs = count_double_tildes(text, size);
     if(pairs % 2 != 0) {
         /* Verify there's content after the opening ~~ */
-        unsigned i;
+        MD_SIZE i;
+        int meaningful = 0;     /* Anything meaningful in text[i .. size-1] */
         for(i = size; i >= 2; i--) {
             if(text[i-2] == '~' && text[i-1] == '~') {
-                if(i < size && has_meaningful_content(text, i, size)) {
+                if(i < size && meaningful) {
                     buf_append(buf, "~~", 2);
                     return;
                 }
             }
+            meaningful |= is_meaningful_char(text[i - 1]);
         }
     }
 }
@@ -846,20 +900,20 @@ static void
 heal_katex(HEAL_BUF* buf)
 {
     const char* text = buf->data;
-    unsigned size = buf->size;
-    unsigned pairs;
+    MD_SIZE size = buf->size;
+    MD_SIZE pairs;
 
     if(in_fenced_code_block(text, size, size)) return;
 
     pairs = count_double_dollars(text, size);
     if(pairs % 2 != 0) {
         /* Check if the $$ content contains a newline (block math) */
-        unsigned i;
+        MD_SIZE i;
         int has_newline = 0;
         /* Find the opening $$ */
         for(i = size; i >= 2; i--) {
             if(text[i-2] == '$' && text[i-1] == '$') {
-                unsigned j;
+                MD_SIZE j;
                 for(j = i; j < size; j++) {
                     if(text[j] == '\n') { has_newline = 1; break; }
                 }
@@ -880,12 +934,12 @@ heal_katex(HEAL_BUF* buf)
  ***************************/
 
 /* Find matching opening bracket going backwards from closeIndex */
-static int
-find_matching_open_bracket(const char* text, unsigned close_idx)
+static HEAL_SPOS
+find_matching_open_bracket(const char* text, MD_SIZE close_idx)
 {
     int depth = 0;
-    int i;
-    for(i = (int)close_idx; i >= 0; i--) {
+    HEAL_SPOS i;
+    for(i = (HEAL_SPOS)close_idx; i >= 0; i--) {
         if(text[i] == ']') depth++;
         else if(text[i] == '[') {
             depth--;
@@ -899,36 +953,37 @@ static void
 heal_links_and_images(HEAL_BUF* buf)
 {
     const char* text = buf->data;
-    unsigned size = buf->size;
-    int i;
+    MD_SIZE size = buf->size;
+    int close_after;    /* Any unescaped ] after i (case 2) */
+    HEAL_SPOS i;
 
     if(in_fenced_code_block(text, size, size)) return;
 
     /* Case 1: Incomplete URL — [text](url  (no closing paren) */
-    for(i = (int)size - 1; i >= 1; i--) {
+    for(i = (HEAL_SPOS)size - 1; i >= 1; i--) {
         if(text[i] == '(' && text[i - 1] == ']') {
             /* Found ]( — check if there's a closing ) after */
-            unsigned j;
+            MD_SIZE j;
             int has_close = 0;
-            for(j = (unsigned)(i + 1); j < size; j++) {
+            for(j = (MD_SIZE)(i + 1); j < size; j++) {
                 if(text[j] == ')') { has_close = 1; break; }
                 if(text[j] == '\n') break;
             }
             if(!has_close) {
                 /* Find matching [ */
-                int open = find_matching_open_bracket(text, (unsigned)(i - 1));
+                HEAL_SPOS open = find_matching_open_bracket(text, (MD_SIZE)(i - 1));
                 if(open >= 0) {
                     int is_image = (open > 0 && text[open - 1] == '!');
                     if(is_image) {
                         /* Remove entire image markup */
-                        unsigned img_start = (unsigned)(open - 1);
+                        MD_SIZE img_start = (MD_SIZE)(open - 1);
                         buf->size = img_start;
                         /* Trim trailing whitespace */
                         while(buf->size > 0 && (buf->data[buf->size - 1] == ' ' || buf->data[buf->size - 1] == '\t'))
                             buf->size--;
                     } else {
                         /* Complete the link with a placeholder */
-                        buf->size = (unsigned)(i + 1); /* keep ]( */
+                        buf->size = (MD_SIZE)(i + 1); /* keep ]( */
                         buf_append(buf, ")", 1);
                     }
                     return;
@@ -939,24 +994,22 @@ heal_links_and_images(HEAL_BUF* buf)
     }
 
     /* Case 2: Incomplete text — [text  (no closing ]) */
-    for(i = (int)size - 1; i >= 0; i--) {
-        if(text[i] == '[' && !is_escaped(text, (unsigned)i)) {
+    close_after = 0;
+    for(i = (HEAL_SPOS)size - 1; i >= 0; i--) {
+        if(text[i] == ']' && !is_escaped(text, (MD_SIZE)i)) {
+            close_after = 1;
+        } else if(text[i] == '[' && !is_escaped(text, (MD_SIZE)i)) {
             /* Check this [ doesn't have a matching ] */
-            unsigned j;
-            int has_close = 0;
-            for(j = (unsigned)(i + 1); j < size; j++) {
-                if(text[j] == ']' && !is_escaped(text, j)) { has_close = 1; break; }
-            }
-            if(!has_close) {
+            if(!close_after) {
                 int is_image = (i > 0 && text[i - 1] == '!');
                 if(is_image) {
                     /* Remove entire image start */
-                    buf->size = (unsigned)(i - 1);
+                    buf->size = (MD_SIZE)(i - 1);
                     while(buf->size > 0 && (buf->data[buf->size - 1] == ' ' || buf->data[buf->size - 1] == '\t'))
                         buf->size--;
                 } else {
                     /* Just remove the opening [ */
-                    unsigned after = (unsigned)(i + 1);
+                    MD_SIZE after = (MD_SIZE)(i + 1);
                     memmove(buf->data + i, buf->data + after, buf->size - after);
                     buf->size -= 1;
                 }
@@ -975,22 +1028,22 @@ static void
 heal_html_tag(HEAL_BUF* buf)
 {
     const char* text = buf->data;
-    unsigned size = buf->size;
-    int i;
+    MD_SIZE size = buf->size;
+    HEAL_SPOS i;
 
     /* Find unclosed < at end */
-    for(i = (int)size - 1; i >= 0; i--) {
+    for(i = (HEAL_SPOS)size - 1; i >= 0; i--) {
         if(text[i] == '>') return; /* Tag is closed */
         if(text[i] == '\n') return; /* Tags don't span lines */
         if(text[i] == '<') {
             /* Verify it looks like a tag (next char is letter or /) */
-            if((unsigned)(i + 1) < size) {
+            if((MD_SIZE)(i + 1) < size) {
                 char next = text[i + 1];
                 if((next >= 'a' && next <= 'z') ||
                    (next >= 'A' && next <= 'Z') || next == '/') {
                     /* Check not inside code block */
-                    if(!in_fenced_code_block(text, size, (unsigned)i)) {
-                        buf->size = (unsigned)i;
+                    if(!in_fenced_code_block(text, size, (MD_SIZE)i)) {
+                        buf->size = (MD_SIZE)i;
                         /* Trim trailing whitespace */
                         while(buf->size > 0 &&
                               (buf->data[buf->size - 1] == ' ' || buf->data[buf->size - 1] == '\t'))
@@ -1009,35 +1062,45 @@ heal_html_tag(HEAL_BUF* buf)
  ***************************/
 
 /* Escape > as \> in list items where it's a comparison operator, not a blockquote.
- * Pattern: list-marker + space + > + optional = + digit */
+ * Pattern: list-marker + space + > + optional = + digit
+ *
+ * The escaped text is built in a second buffer, which replaces buf->data only
+ * if anything was escaped. */
 static void
 heal_comparison_operators(HEAL_BUF* buf)
 {
-    unsigned size = buf->size;
-    unsigned i = 0;
+    const char* text = buf->data;
+    MD_SIZE size = buf->size;
+    MD_SIZE i = 0;
+    MD_SIZE copied = 0;        /* text[0 .. copied) is already in out */
+    MD_SIZE fence_at = 0;      /* Fence scan position (always a line start) */
+    int in_fence = 0;
+    HEAL_BUF out;
+
+    out.data = NULL;
 
     while(i < size) {
         /* Find start of line */
-        unsigned ls = i;
+        MD_SIZE ls = i;
 
         /* Skip whitespace */
-        while(i < size && (buf->data[i] == ' ' || buf->data[i] == '\t')) i++;
+        while(i < size && (text[i] == ' ' || text[i] == '\t')) i++;
 
         /* Check for list marker */
         int is_list = 0;
         if(i < size) {
-            if(buf->data[i] == '-' || buf->data[i] == '*' || buf->data[i] == '+') {
-                unsigned after = i + 1;
-                if(after < size && buf->data[after] == ' ') {
+            if(text[i] == '-' || text[i] == '*' || text[i] == '+') {
+                MD_SIZE after = i + 1;
+                if(after < size && text[after] == ' ') {
                     is_list = 1;
                     i = after + 1;
                 }
-            } else if(buf->data[i] >= '0' && buf->data[i] <= '9') {
-                unsigned j = i;
-                while(j < size && buf->data[j] >= '0' && buf->data[j] <= '9') j++;
-                if(j < size && (buf->data[j] == '.' || buf->data[j] == ')')) {
+            } else if(text[i] >= '0' && text[i] <= '9') {
+                MD_SIZE j = i;
+                while(j < size && text[j] >= '0' && text[j] <= '9') j++;
+                if(j < size && (text[j] == '.' || text[j] == ')')) {
                     j++;
-                    if(j < size && buf->data[j] == ' ') {
+                    if(j < size && text[j] == ' ') {
                         is_list = 1;
                         i = j + 1;
                     }
@@ -1045,37 +1108,48 @@ heal_comparison_operators(HEAL_BUF* buf)
             }
         }
 
-        if(is_list && i < size && buf->data[i] == '>') {
+        if(is_list && i < size && text[i] == '>') {
             /* Check what follows > */
-            unsigned gt_pos = i;
+            MD_SIZE gt_pos = i;
             i++;
-            if(i < size && buf->data[i] == '=') { i++; }
+            if(i < size && text[i] == '=') { i++; }
             /* Skip optional spaces */
-            while(i < size && buf->data[i] == ' ') i++;
+            while(i < size && text[i] == ' ') i++;
             /* Optional $ */
-            if(i < size && buf->data[i] == '$') i++;
+            if(i < size && text[i] == '$') i++;
             /* Check for digit */
-            if(i < size && buf->data[i] >= '0' && buf->data[i] <= '9') {
-                /* This is a comparison operator — need to escape > */
-                if(!in_fenced_code_block(buf->data, size, gt_pos)) {
-                    /* Insert \ before > */
-                    unsigned old_size = buf->size;
-                    buf_append_ch(buf, 0); /* grow by 1 */
-                    if(buf->size <= old_size)
-                        return; /* realloc failed */
-                    memmove(buf->data + gt_pos + 1, buf->data + gt_pos, old_size - gt_pos);
-                    buf->data[gt_pos] = '\\';
-                    size = buf->size;
-                    i++; /* adjust for inserted char */
+            if(i < size && text[i] >= '0' && text[i] <= '9') {
+                /* This is a comparison operator — need to escape > unless it
+                 * is in a code block. Only the list marker lies between the
+                 * line start and the >, so the fence state at the line start
+                 * is the one at the >. */
+                in_fence = scan_fences(text, ls, &fence_at, in_fence);
+                if(!in_fence) {
+                    if(out.data == NULL) {
+                        buf_init(&out, size + 64);
+                        if(!out.data) { buf->error = 1; return; }
+                    }
+                    buf_append(&out, text + copied, gt_pos - copied);
+                    buf_append_ch(&out, '\\');
+                    copied = gt_pos;
                 }
             }
         }
 
         /* Skip to end of line */
-        while(i < size && buf->data[i] != '\n') i++;
+        while(i < size && text[i] != '\n') i++;
         if(i < size) i++; /* skip \n */
+    }
 
-        (void) ls;
+    if(out.data != NULL) {
+        buf_append(&out, text + copied, size - copied);
+        if(out.error) {
+            buf_free(&out);
+            buf->error = 1;
+            return;
+        }
+        buf_free(buf);
+        *buf = out;
     }
 }
 
@@ -1084,8 +1158,8 @@ heal_comparison_operators(HEAL_BUF* buf)
  ***  Main heal function ***
  ***************************/
 
-int md_heal(const char* input, unsigned input_size,
-            void (*process_output)(const char*, unsigned, void*),
+int md_heal(const char* input, MD_SIZE input_size,
+            void (*process_output)(const char*, MD_SIZE, void*),
             void* userdata)
 {
     HEAL_BUF buf;
@@ -30,6 +30,8 @@
 #ifndef MD4X_HEAL_H
 #define MD4X_HEAL_H
 
+#include "md4x.h"
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -47,8 +49,8 @@ extern "C"
      *
      * Returns 0 on success, -1 on error.
      */
-    int md_heal(const char *input, unsigned input_size,
-                void (*process_output)(const char *, unsigned, void *),
+    int md_heal(const char *input, MD_SIZE input_size,
+                void (*process_output)(const char *, MD_SIZE, void *),
                 void *userdata);
 
 #ifdef __cplusplus
@@ -30,7 +30,9 @@
 
 #include "md4x-html.h"
 #include "md4x-props.h"
+#include "md4x-yaml.h"
 #include "md4x-heal-wrap.h"
+#include "md4x-render.h"
 #include "entity.h"
 
 
@@ -103,6 +105,12 @@ struct MD_HTML_tag {
     MD_HTML_CODE_META* code_blocks;
     int n_code_blocks;
     int code_blocks_cap;
+
+    /* Top-level block boundary tracking (only active when MD_HTML_FLAG_BLOCK_META is set) */
+    int block_depth;
+    MD_SIZE* block_ends;        /* Byte offset after each top-level block */
+    int n_block_ends;
+    int block_ends_cap;
 };
 
 #define NEED_HTML_ESC_FLAG   0x1
@@ -123,7 +131,7 @@ static inline void
 render_verbatim(MD_HTML* r, const MD_CHAR* text, MD_SIZE size)
 {
     r->process_output(text, size, r->userdata);
-    if(r->flags & MD_HTML_FLAG_CODE_META)
+    if(r->flags & (MD_HTML_FLAG_CODE_META | MD_HTML_FLAG_BLOCK_META))
         r->output_offset += size;
 }
 
@@ -551,19 +559,43 @@ comp_fm_tag_capture(const MD_CHAR* text, MD_SIZE size, void* userdata)
     comp_fm_tag_append((MD_HTML*) userdata, text, size);
 }
 
+/* Emit scalar entries of a flat YAML mapping as HTML attributes (lists are
+ * skipped, like nested structures in the libyaml path below). */
+static void
+render_yaml_fast_attrs(MD_HTML* r, const YAML_FAST_DOC* doc)
+{
+    int i;
+
+    for(i = 0; i < doc->n_entries; i++) {
+        const YAML_FAST_ENTRY* e = &doc->entries[i];
+        if(e->n_items >= 0)
+            continue;
+        RENDER_VERBATIM(r, " ");
+        render_html_escaped(r, e->key.str, e->key.size);
+        RENDER_VERBATIM(r, "=\"");
+        render_html_escaped(r, e->value.str, e->value.size);
+        RENDER_VERBATIM(r, "\"");
+    }
+}
+
 /* Flush the buffered component open tag. If YAML text was captured,
  * parse it and emit as HTML attributes before closing ">". */
 static void
 comp_fm_flush_tag(MD_HTML* r)
 {
+    YAML_FAST_DOC fast;
+
     if(r->comp_fm_tag == NULL || r->comp_fm_tag_size == 0)
         return;
 
     /* Emit the buffered tag prefix (e.g. "<card ...props"). */
-    r->process_output(r->comp_fm_tag, r->comp_fm_tag_size, r->userdata);
+    render_verbatim(r, r->comp_fm_tag, r->comp_fm_tag_size);
 
     /* If we captured YAML, parse and emit as attributes. */
-    if(r->comp_fm_text != NULL && r->comp_fm_text_size > 0) {
+    if(r->comp_fm_text != NULL && r->comp_fm_text_size > 0
+       && yaml_fast_scan(r->comp_fm_text, r->comp_fm_text_size, &fast) == 0) {
+        render_yaml_fast_attrs(r, &fast);
+    } else if(r->comp_fm_text != NULL && r->comp_fm_text_size > 0) {
         yaml_parser_t yp;
         yaml_event_t event;
 
@@ -676,25 +708,30 @@ render_open_block_component(MD_HTML* r, const MD_BLOCK_COMPONENT_DETAIL* det)
         {
             void (*saved_output)(const MD_CHAR*, MD_SIZE, void*) = r->process_output;
             void* saved_ud = r->userdata;
+            MD_SIZE saved_offset = r->output_offset;
             r->process_output = comp_fm_tag_capture;
             r->userdata = r;
             render_html_escaped(r, det->title, det->title_size);
             r->process_output = saved_output;
             r->userdata = saved_ud;
+            r->output_offset = saved_offset;
         }
         comp_fm_tag_append(r, "\"", 1);
     }
 
     /* Append {props} if present. */
     if(det->raw_props != NULL && det->raw_props_size > 0) {
-        /* Render props to a temp buffer by capturing output. */
+        /* Render props to a temp buffer by capturing output. The captured
+         * bytes are counted once the tag gets flushed. */
         void (*saved_output)(const MD_CHAR*, MD_SIZE, void*) = r->process_output;
         void* saved_ud = r->userdata;
+        MD_SIZE saved_offset = r->output_offset;
         r->process_output = comp_fm_tag_capture;
         r->userdata = r;
         render_html_component_props(r, det->raw_props, det->raw_props_size);
         r->process_output = saved_output;
         r->userdata = saved_ud;
+        r->output_offset = saved_offset;
     }
 
     r->comp_fm_pending = 1;
@@ -795,8 +832,8 @@ render_code_meta_json(MD_HTML* r)
         MD_HTML_CODE_META* m = &r->code_blocks[i];
         if(i > 0) out(",", 1, ud);
 
-        n = snprintf(buf, sizeof(buf), "{\"s\":%u,\"e\":%u",
-                     (unsigned)m->start, (unsigned)m->end);
+        n = snprintf(buf, sizeof(buf), "{\"s\":%llu,\"e\":%llu",
+                     (unsigned long long)m->start, (unsigned long long)m->end);
         out(buf, (MD_SIZE)n, ud);
 
         if(m->lang_size > 0) {
@@ -823,6 +860,44 @@ render_code_meta_json(MD_HTML* r)
 }
 
 
+/*****************************************
+ ***  Top-level block boundary tracking ***
+ *****************************************/
+
+/* Record the current output offset as the end of a top-level block. */
+static int
+block_meta_push(MD_HTML* r)
+{
+    if(r->n_block_ends >= r->block_ends_cap) {
+        int new_cap = (r->block_ends_cap > 0) ? r->block_ends_cap * 2 : 32;
+        MD_SIZE* p = (MD_SIZE*) realloc(r->block_ends, new_cap * sizeof(MD_SIZE));
+        if(p == NULL) return -1;
+        r->block_ends = p;
+        r->block_ends_cap = new_cap;
+    }
+    r->block_ends[r->n_block_ends++] = r->output_offset;
+    return 0;
+}
+
+/* Emit "\0" followed by a JSON array of top-level block end offsets. */
+static void
+render_block_meta_json(MD_HTML* r)
+{
+    void (*out)(const MD_CHAR*, MD_SIZE, void*) = r->process_output;
+    void* ud = r->userdata;
+    char buf[32];
+    int i, n;
+
+    out("\0", 1, ud);
+    out("[", 1, ud);
+    for(i = 0; i < r->n_block_ends; i++) {
+        n = snprintf(buf, sizeof(buf), (i > 0) ? ",%llu" : "%llu",
+                     (unsigned long long)r->block_ends[i]);
+        out(buf, (MD_SIZE)n, ud);
+    }
+    out("]", 1, ud);
+}
+
 static void
 render_open_alert_block(MD_HTML* r, const MD_BLOCK_ALERT_DETAIL* det)
 {
@@ -869,10 +944,38 @@ parse_frontmatter_meta(const char* text, MD_SIZE size,
 {
     yaml_parser_t yp;
     yaml_event_t event;
+    YAML_FAST_DOC fast;
+    int i;
 
     *out_title = NULL;
     *out_description = NULL;
 
+    if(yaml_fast_scan(text, size, &fast) == 0) {
+        for(i = 0; i < fast.n_entries; i++) {
+            const YAML_FAST_ENTRY* e = &fast.entries[i];
+            char** target = NULL;
+            char* s;
+
+            if(e->n_items >= 0 || e->value.size == 0)
+                continue;
+            if(e->key.size == 5 && memcmp(e->key.str, "title", 5) == 0)
+                target = out_title;
+            else if(e->key.size == 11 && memcmp(e->key.str, "description", 11) == 0)
+                target = out_description;
+            if(target == NULL)
+                continue;
+
+            s = (char*) malloc(e->value.size + 1);
+            if(s != NULL) {
+                memcpy(s, e->value.str, e->value.size);
+                s[e->value.size] = '\0';
+                free(*target);
+                *target = s;
+            }
+        }
+        return;
+    }
+
     if(!yaml_parser_initialize(&yp))
         return;
 
@@ -1030,6 +1133,9 @@ enter_block_callback(MD_BLOCKTYPE type, void* detail, void* userdata)
     if((r->flags & MD_HTML_FLAG_FULL_HTML) && type != MD_BLOCK_DOC)
         ensure_head_emitted(r);
 
+    if(type != MD_BLOCK_DOC)
+        r->block_depth++;
+
     switch(type) {
         case MD_BLOCK_DOC:      /* noop */ break;
         case MD_BLOCK_QUOTE:    RENDER_VERBATIM(r, "<blockquote>\n"); break;
@@ -1140,6 +1246,11 @@ leave_block_callback(MD_BLOCKTYPE type, void* detail, void* userdata)
         case MD_BLOCK_TEMPLATE:     RENDER_VERBATIM(r, "</template>\n"); break;
     }
 
+    if(type != MD_BLOCK_DOC  &&  --r->block_depth == 0  &&  (r->flags & MD_HTML_FLAG_BLOCK_META)) {
+        if(block_meta_push(r) != 0)
+            return -1;
+    }
+
     return 0;
 }
 
@@ -1274,6 +1385,69 @@ debug_log_callback(const char* msg, void* userdata)
         fprintf(stderr, "MD4X: %s\n", msg);
 }
 
+/* Initialize the renderer context and install its md_parse() callbacks.
+ * Shared by md_html_ex() and md_render_multi(). */
+static void
+html_begin(void* ctx, MD_PARSER* parser,
+           void (*process_output)(const MD_CHAR*, MD_SIZE, void*),
+           void* userdata, unsigned renderer_flags)
+{
+    MD_HTML* r = (MD_HTML*) ctx;
+    int i;
+
+    memset(r, 0, sizeof(MD_HTML));
+    r->process_output = process_output;
+    r->userdata = userdata;
+    r->flags = renderer_flags;
+
+    parser->enter_block = enter_block_callback;
+    parser->leave_block = leave_block_callback;
+    parser->enter_span = enter_span_callback;
+    parser->leave_span = leave_span_callback;
+    parser->text = text_callback;
+    parser->debug_log = debug_log_callback;
+
+    /* Build map of characters which need escaping. */
+    for(i = 0; i < 256; i++) {
+        unsigned char ch = (unsigned char) i;
+
+        if(strchr("\"&<>", ch) != NULL)
+            r->escape_map[i] |= NEED_HTML_ESC_FLAG;
+
+        if(!ISALNUM(ch)  &&  strchr("~-_.+!*(),%#@?=;:/,+$", ch) == NULL)
+            r->escape_map[i] |= NEED_URL_ESC_FLAG;
+    }
+}
+
+/* Emit trailing metadata and release the context after md_parse(). */
+static int
+html_end(void* ctx, int ret)
+{
+    MD_HTML* r = (MD_HTML*) ctx;
+
+    if(r->flags & MD_HTML_FLAG_CODE_META) {
+        if(ret == 0)
+            render_code_meta_json(r);
+        code_meta_cleanup(r);
+    }
+
+    if(r->flags & MD_HTML_FLAG_BLOCK_META) {
+        if(ret == 0)
+            render_block_meta_json(r);
+        free(r->block_ends);
+    }
+
+    free(r->fm_text);
+    free(r->comp_fm_tag);
+    free(r->comp_fm_text);
+
+    return ret;
+}
+
+const MD_RENDER_HOOKS md_html_render_hooks = {
+    sizeof(MD_HTML), html_begin, html_end
+};
+
 int
 md_html_ex(const MD_CHAR* input, MD_SIZE input_size,
            void (*process_output)(const MD_CHAR*, MD_SIZE, void*),
@@ -1282,7 +1456,6 @@ md_html_ex(const MD_CHAR* input, MD_SIZE input_size,
 {
     MD_HTML render;
     MD_PARSER parser;
-    int i;
     int ret;
 
     /* Heal-before-render: run md_heal first, then render the healed output. */
@@ -1298,31 +1471,10 @@ md_html_ex(const MD_CHAR* input, MD_SIZE input_size,
         return ret;
     }
 
-    memset(&render, 0, sizeof(render));
-    render.process_output = process_output;
-    render.userdata = userdata;
-    render.flags = renderer_flags;
-    render.opts = opts;
-
     memset(&parser, 0, sizeof(parser));
+    html_begin(&render, &parser, process_output, userdata, renderer_flags);
     parser.flags = parser_flags;
-    parser.enter_block = enter_block_callback;
-    parser.leave_block = leave_block_callback;
-    parser.enter_span = enter_span_callback;
-    parser.leave_span = leave_span_callback;
-    parser.text = text_callback;
-    parser.debug_log = debug_log_callback;
-
-    /* Build map of characters which need escaping. */
-    for(i = 0; i < 256; i++) {
-        unsigned char ch = (unsigned char) i;
-
-        if(strchr("\"&<>", ch) != NULL)
-            render.escape_map[i] |= NEED_HTML_ESC_FLAG;
-
-        if(!ISALNUM(ch)  &&  strchr("~-_.+!*(),%#@?=;:/,+$", ch) == NULL)
-            render.escape_map[i] |= NEED_URL_ESC_FLAG;
-    }
+    render.opts = opts;
 
     /* Consider skipping UTF-8 byte order mark (BOM). */
     if(renderer_flags & MD_HTML_FLAG_SKIP_UTF8_BOM  &&  sizeof(MD_CHAR) == 1) {
@@ -1334,18 +1486,7 @@ md_html_ex(const MD_CHAR* input, MD_SIZE input_size,
     }
 
     ret = md_parse(input, input_size, &parser, (void*) &render);
-
-    if(renderer_flags & MD_HTML_FLAG_CODE_META) {
-        if(ret == 0)
-            render_code_meta_json(&render);
-        code_meta_cleanup(&render);
-    }
-
-    free(render.fm_text);
-    free(render.comp_fm_tag);
-    free(render.comp_fm_text);
-
-    return ret;
+    return html_end(&render, ret);
 }
 
 int
@@ -39,6 +39,7 @@ extern "C"
 #define MD_HTML_FLAG_SKIP_UTF8_BOM          0x0004
 #define MD_HTML_FLAG_FULL_HTML              0x0008
 #define MD_HTML_FLAG_CODE_META              0x0010
+#define MD_HTML_FLAG_BLOCK_META             0x0020
 #define MD_HTML_FLAG_HEAL                   0x0100
 
     /* Options for md_html_ex(). */
@@ -30,6 +30,7 @@
 #include <string.h>
 #include <yaml.h>
 #include "md4x.h"
+#include "md4x-yaml.h"
 
 #ifdef _WIN32
 #define json_snprintf _snprintf
@@ -188,17 +189,13 @@ yaml_is_number(const char *s, MD_SIZE len)
     return has_digit;
 }
 
-/* Write a YAML scalar as a typed JSON value.
- * Applies YAML 1.1 type resolution for plain scalars. */
+/* Write a scalar value as a typed JSON value.
+ * Applies YAML 1.1 type resolution for plain (unquoted) scalars. */
 static void
-json_write_yaml_scalar(JSON_WRITER *w, const yaml_event_t *event)
+json_write_yaml_typed(JSON_WRITER *w, const char *val, MD_SIZE len, int quoted)
 {
-    const char *val = (const char *)event->data.scalar.value;
-    MD_SIZE len = (MD_SIZE)event->data.scalar.length;
-    yaml_scalar_style_t style = event->data.scalar.style;
-
     /* Quoted scalars are always strings. */
-    if (style == YAML_SINGLE_QUOTED_SCALAR_STYLE || style == YAML_DOUBLE_QUOTED_SCALAR_STYLE)
+    if (quoted)
     {
         json_write_string(w, val, len);
         return;
@@ -235,6 +232,18 @@ json_write_yaml_scalar(JSON_WRITER *w, const yaml_event_t *event)
     json_write_string(w, val, len);
 }
 
+/* Write a libyaml scalar event as a typed JSON value. */
+static void
+json_write_yaml_scalar(JSON_WRITER *w, const yaml_event_t *event)
+{
+    yaml_scalar_style_t style = event->data.scalar.style;
+
+    json_write_yaml_typed(w, (const char *)event->data.scalar.value,
+                          (MD_SIZE)event->data.scalar.length,
+                          style == YAML_SINGLE_QUOTED_SCALAR_STYLE ||
+                              style == YAML_DOUBLE_QUOTED_SCALAR_STYLE);
+}
+
 /* Forward declarations for recursive YAML-to-JSON writing. */
 static int json_write_yaml_value(JSON_WRITER *w, yaml_parser_t *yp);
 
@@ -379,16 +388,57 @@ json_write_yaml_value(JSON_WRITER *w, yaml_parser_t *yp)
     return -1;
 }
 
-/* Write parsed YAML frontmatter as JSON props using libyaml.
- * Supports nested objects, arrays, and all YAML scalar types.
+/* Write a scanned flat mapping as JSON object key-value pairs (without
+ * outer braces), exactly as json_write_yaml_mapping() would. */
+static int
+json_write_yaml_fast(JSON_WRITER *w, const YAML_FAST_DOC *doc)
+{
+    int i, j;
+
+    for (i = 0; i < doc->n_entries; i++)
+    {
+        const YAML_FAST_ENTRY *e = &doc->entries[i];
+
+        if (i > 0)
+            json_write(w, ",", 1);
+        json_write(w, "\"", 1);
+        json_write_escaped(w, e->key.str, e->key.size);
+        json_write_str(w, "\":");
+
+        if (e->n_items < 0)
+        {
+            json_write_yaml_typed(w, e->value.str, e->value.size, e->value.quoted);
+            continue;
+        }
+
+        json_write(w, "[", 1);
+        for (j = 0; j < e->n_items; j++)
+        {
+            const YAML_FAST_SCALAR *item = &doc->items[e->first_item + j];
+            if (j > 0)
+                json_write(w, ",", 1);
+            json_write_yaml_typed(w, item->str, item->size, item->quoted);
+        }
+        json_write(w, "]", 1);
+    }
+    return doc->n_entries;
+}
+
+/* Write parsed YAML frontmatter as JSON props.
+ * Flat mappings take the yaml_fast_scan() path; everything else goes through
+ * libyaml, which supports nested objects, arrays, and all YAML scalar types.
  * Returns number of top-level props written. */
 static int
 json_write_yaml_props(JSON_WRITER *w, const char *text, MD_SIZE size)
 {
     yaml_parser_t yp;
     yaml_event_t event;
+    YAML_FAST_DOC fast;
     int n_written = 0;
 
+    if (yaml_fast_scan(text, size, &fast) == 0)
+        return json_write_yaml_fast(w, &fast);
+
     if (!yaml_parser_initialize(&yp))
         return 0;
 
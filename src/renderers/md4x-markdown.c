@@ -28,6 +28,7 @@
 
 #include "md4x-markdown.h"
 #include "md4x-heal-wrap.h"
+#include "md4x-render.h"
 #include "entity.h"
 
 
@@ -776,6 +777,37 @@ debug_log_callback(const char* msg, void* userdata)
         fprintf(stderr, "MD4X: %s\n", msg);
 }
 
+static void
+markdown_begin(void* ctx, MD_PARSER* parser,
+               void (*process_output)(const MD_CHAR*, MD_SIZE, void*),
+               void* userdata, unsigned renderer_flags)
+{
+    MD_MARKDOWN* r = (MD_MARKDOWN*) ctx;
+
+    memset(r, 0, sizeof(MD_MARKDOWN));
+    r->process_output = process_output;
+    r->userdata = userdata;
+    r->flags = renderer_flags;
+
+    parser->enter_block = enter_block_callback;
+    parser->leave_block = leave_block_callback;
+    parser->enter_span = enter_span_callback;
+    parser->leave_span = leave_span_callback;
+    parser->text = text_callback;
+    parser->debug_log = debug_log_callback;
+}
+
+static int
+markdown_end(void* ctx, int ret)
+{
+    (void) ctx;
+    return ret;
+}
+
+const MD_RENDER_HOOKS md_markdown_render_hooks = {
+    sizeof(MD_MARKDOWN), markdown_begin, markdown_end
+};
+
 int
 md_markdown(const MD_CHAR* input, MD_SIZE input_size,
              void (*process_output)(const MD_CHAR*, MD_SIZE, void*),
@@ -799,18 +831,8 @@ md_markdown(const MD_CHAR* input, MD_SIZE input_size,
     }
 
     memset(&parser, 0, sizeof(parser));
+    markdown_begin(&render, &parser, process_output, userdata, renderer_flags);
     parser.flags = parser_flags;
-    parser.enter_block = enter_block_callback;
-    parser.leave_block = leave_block_callback;
-    parser.enter_span = enter_span_callback;
-    parser.leave_span = leave_span_callback;
-    parser.text = text_callback;
-    parser.debug_log = debug_log_callback;
-
-    memset(&render, 0, sizeof(render));
-    render.process_output = process_output;
-    render.userdata = userdata;
-    render.flags = renderer_flags;
 
     /* Consider skipping UTF-8 byte order mark (BOM). */
     if(renderer_flags & MD_MARKDOWN_FLAG_SKIP_UTF8_BOM  &&  sizeof(MD_CHAR) == 1) {
@@ -821,5 +843,5 @@ md_markdown(const MD_CHAR* input, MD_SIZE input_size,
         }
     }
 
-    return md_parse(input, input_size, &parser, (void*) &render);
+    return markdown_end(&render, md_parse(input, input_size, &parser, (void*) &render));
 }
@@ -30,6 +30,7 @@
 #include "md4x-meta.h"
 #include "md4x-json.h"
 #include "md4x-heal-wrap.h"
+#include "md4x-render.h"
 #include "entity.h"
 
 
@@ -373,13 +374,59 @@ meta_free(META_CTX* ctx)
  ***  Public API                    ***
  **************************************/
 
+/* Renderer context together with its output sink. META_CTX comes first so
+ * the md_parse() callbacks can treat a META_RENDER* as their META_CTX*. */
+typedef struct {
+    META_CTX ctx;
+    JSON_WRITER writer;
+} META_RENDER;
+
+static void
+meta_begin(void* ctx, MD_PARSER* parser,
+           void (*process_output)(const MD_CHAR*, MD_SIZE, void*),
+           void* userdata, unsigned renderer_flags)
+{
+    META_RENDER* r = (META_RENDER*) ctx;
+
+    memset(r, 0, sizeof(META_RENDER));
+    r->writer.process_output = process_output;
+    r->writer.userdata = userdata;
+
+    parser->enter_block = meta_enter_block;
+    parser->leave_block = meta_leave_block;
+    parser->enter_span = meta_enter_span;
+    parser->leave_span = meta_leave_span;
+    parser->text = meta_text;
+    parser->debug_log = (renderer_flags & MD_META_FLAG_DEBUG) ? meta_debug_log : NULL;
+}
+
+static int
+meta_end(void* ctx, int ret)
+{
+    META_RENDER* r = (META_RENDER*) ctx;
+
+    if(ret != 0 || r->ctx.error != 0) {
+        meta_free(&r->ctx);
+        return -1;
+    }
+
+    /* Serialize metadata to JSON via the output callback. */
+    meta_serialize(&r->writer, &r->ctx);
+
+    meta_free(&r->ctx);
+    return 0;
+}
+
+const MD_RENDER_HOOKS md_meta_render_hooks = {
+    sizeof(META_RENDER), meta_begin, meta_end
+};
+
 int
 md_meta(const MD_CHAR* input, MD_SIZE input_size,
         void (*process_output)(const MD_CHAR*, MD_SIZE, void*),
         void* userdata, unsigned parser_flags, unsigned renderer_flags)
 {
-    META_CTX ctx;
-    JSON_WRITER writer;
+    META_RENDER render;
     MD_PARSER parser;
     int ret;
 
@@ -397,15 +444,10 @@ md_meta(const MD_CHAR* input, MD_SIZE input_size,
     }
 
     memset(&parser, 0, sizeof(parser));
-    parser.flags = parser_flags;
-    parser.enter_block = meta_enter_block;
-    parser.leave_block = meta_leave_block;
-    parser.enter_span = meta_enter_span;
-    parser.leave_span = meta_leave_span;
-    parser.text = meta_text;
-    parser.debug_log = (renderer_flags & MD_META_FLAG_DEBUG) ? meta_debug_log : NULL;
-
-    memset(&ctx, 0, sizeof(ctx));
+    meta_begin(&render, &parser, process_output, userdata, renderer_flags);
+    /* Only frontmatter and heading text are consumed; skip inline analysis
+     * of paragraphs and tables. */
+    parser.flags = parser_flags | MD_FLAG_HEADINGINLINESONLY;
 
 #ifndef MD4X_USE_ASCII
     /* Skip UTF-8 BOM. */
@@ -418,18 +460,6 @@ md_meta(const MD_CHAR* input, MD_SIZE input_size,
     }
 #endif
 
-    ret = md_parse(input, input_size, &parser, (void*) &ctx);
-
-    if(ret != 0 || ctx.error != 0) {
-        meta_free(&ctx);
-        return -1;
-    }
-
-    /* Serialize metadata to JSON via the output callback. */
-    writer.process_output = process_output;
-    writer.userdata = userdata;
-    meta_serialize(&writer, &ctx);
-
-    meta_free(&ctx);
-    return 0;
+    ret = md_parse(input, input_size, &parser, (void*) &render);
+    return meta_end(&render, ret);
 }
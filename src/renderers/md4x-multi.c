@@ -0,0 +1,253 @@
+/*
+ * MD4X: Markdown parser for C
+ * (http://github.com/unjs/md4x)
+ *
+ * Copyright (c) 2026 Pooya Parsa <pooya@pi0.io>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "md4x-multi.h"
+#include "md4x-render.h"
+#include "md4x-heal-wrap.h"
+#include "md4x-trace.h"
+
+
+typedef struct MULTI_CTX {
+    int n;
+    MD_RENDER_FORMAT formats[MD_MULTI_MAX_TARGETS];
+    const MD_RENDER_HOOKS* hooks[MD_MULTI_MAX_TARGETS];
+    MD_PARSER parsers[MD_MULTI_MAX_TARGETS];
+    void* ctxs[MD_MULTI_MAX_TARGETS];
+} MULTI_CTX;
+
+#ifdef MD4X_TRACE
+/* Trace event names of the targets' callbacks, indexed by MD_RENDER_FORMAT. */
+static const char* multi_trace_names[] = { "html", "ast", "meta", "text", "ansi", "markdown" };
+#endif
+
+
+/**************************************
+ ***  Fan-out md_parse() callbacks  ***
+ **************************************/
+
+static int
+multi_enter_block(MD_BLOCKTYPE type, void* detail, void* userdata)
+{
+    MULTI_CTX* m = (MULTI_CTX*) userdata;
+    int i, ret;
+
+    for(i = 0; i < m->n; i++) {
+        MD_TRACE_BEGIN(multi_trace_names[m->formats[i]], "type", type);
+        ret = m->parsers[i].enter_block(type, detail, m->ctxs[i]);
+        MD_TRACE_END(multi_trace_names[m->formats[i]]);
+        if(ret != 0)
+            return ret;
+    }
+    return 0;
+}
+
+static int
+multi_leave_block(MD_BLOCKTYPE type, void* detail, void* userdata)
+{
+    MULTI_CTX* m = (MULTI_CTX*) userdata;
+    int i, ret;
+
+    for(i = 0; i < m->n; i++) {
+        MD_TRACE_BEGIN(multi_trace_names[m->formats[i]], "type", type);
+        ret = m->parsers[i].leave_block(type, detail, m->ctxs[i]);
+        MD_TRACE_END(multi_trace_names[m->formats[i]]);
+        if(ret != 0)
+            return ret;
+    }
+    return 0;
+}
+
+static int
+multi_enter_span(MD_SPANTYPE type, void* detail, void* userdata)
+{
+    MULTI_CTX* m = (MULTI_CTX*) userdata;
+    int i, ret;
+
+    for(i = 0; i < m->n; i++) {
+        MD_TRACE_BEGIN(multi_trace_names[m->formats[i]], "type", type);
+        ret = m->parsers[i].enter_span(type, detail, m->ctxs[i]);
+        MD_TRACE_END(multi_trace_names[m->formats[i]]);
+        if(ret != 0)
+            return ret;
+    }
+    return 0;
+}
+
+static int
+multi_leave_span(MD_SPANTYPE type, void* detail, void* userdata)
+{
+    MULTI_CTX* m = (MULTI_CTX*) userdata;
+    int i, ret;
+
+    for(i = 0; i < m->n; i++) {
+        MD_TRACE_BEGIN(multi_trace_names[m->formats[i]], "type", type);
+        ret = m->parsers[i].leave_span(type, detail, m->ctxs[i]);
+        MD_TRACE_END(multi_trace_names[m->formats[i]]);
+        if(ret != 0)
+            return ret;
+    }
+    return 0;
+}
+
+static int
+multi_text(MD_TEXTTYPE type, const MD_CHAR* text, MD_SIZE size, void* userdata)
+{
+    MULTI_CTX* m = (MULTI_CTX*) userdata;
+    int i, ret;
+
+    for(i = 0; i < m->n; i++) {
+        MD_TRACE_BEGIN(multi_trace_names[m->formats[i]], "size", size);
+        ret = m->parsers[i].text(type, text, size, m->ctxs[i]);
+        MD_TRACE_END(multi_trace_names[m->formats[i]]);
+        if(ret != 0)
+            return ret;
+    }
+    return 0;
+}
+
+/* Forward to every renderer with a debug_log(); each one checks its own
+ * DEBUG flag. */
+static void
+multi_debug_log(const char* msg, void* userdata)
+{
+    MULTI_CTX* m = (MULTI_CTX*) userdata;
+    int i;
+
+    for(i = 0; i < m->n; i++) {
+        if(m->parsers[i].debug_log != NULL)
+            m->parsers[i].debug_log(msg, m->ctxs[i]);
+    }
+}
+
+
+/**********************
+ ***  Public API    ***
+ **********************/
+
+static const MD_RENDER_HOOKS*
+multi_hooks(MD_RENDER_FORMAT format)
+{
+    switch(format) {
+        case MD_RENDER_HTML:    return &md_html_render_hooks;
+        case MD_RENDER_AST:     return &md_ast_render_hooks;
+        case MD_RENDER_META:    return &md_meta_render_hooks;
+        case MD_RENDER_TEXT:    return &md_text_render_hooks;
+        case MD_RENDER_ANSI:    return &md_ansi_render_hooks;
+        case MD_RENDER_MARKDOWN: return &md_markdown_render_hooks;
+    }
+    return NULL;
+}
+
+int
+md_render_multi(const MD_CHAR* input, MD_SIZE input_size,
+                const MD_RENDER_TARGET* targets, int n_targets,
+                unsigned parser_flags, unsigned flags,
+                const MD_LIMITS* limits, MD_PARSE_STATS* stats)
+{
+    MULTI_CTX m;
+    MD_PARSER parser;
+    void* userdata = (void*) &m;
+    int i, ret, end_ret;
+
+    if(n_targets < 0 || n_targets > MD_MULTI_MAX_TARGETS)
+        return -1;
+    for(i = 0; i < n_targets; i++) {
+        if(multi_hooks(targets[i].format) == NULL)
+            return -1;
+    }
+
+    /* Heal-before-render: heal once, then fan out the healed input. */
+    if(flags & MD_MULTI_FLAG_HEAL) {
+        MD4X_HEAL_BUF hbuf;
+        if(md4x_heal_input(input, input_size, &hbuf) != 0) {
+            free(hbuf.data);
+            return -1;
+        }
+        ret = md_render_multi(hbuf.data, hbuf.size, targets, n_targets,
+                              parser_flags, flags & ~MD_MULTI_FLAG_HEAL, limits, stats);
+        free(hbuf.data);
+        return ret;
+    }
+
+    memset(&m, 0, sizeof(m));
+    for(i = 0; i < n_targets; i++) {
+        const MD_RENDER_HOOKS* hooks = multi_hooks(targets[i].format);
+        void* ctx = malloc(hooks->ctx_size);
+        if(ctx == NULL)
+            break;
+        hooks->begin(ctx, &m.parsers[i], targets[i].process_output,
+                     targets[i].userdata, targets[i].renderer_flags & ~MD4X_FLAG_HEAL);
+        m.formats[i] = targets[i].format;
+        m.hooks[i] = hooks;
+        m.ctxs[i] = ctx;
+        m.n++;
+    }
+
+    ret = -1;
+    if(m.n == n_targets) {
+        memset(&parser, 0, sizeof(parser));
+        parser.flags = parser_flags;
+        parser.enter_block = multi_enter_block;
+        parser.leave_block = multi_leave_block;
+        parser.enter_span = multi_enter_span;
+        parser.leave_span = multi_leave_span;
+        parser.text = multi_text;
+        parser.debug_log = multi_debug_log;
+
+        /* Consider skipping UTF-8 byte order mark (BOM). */
+        if(flags & MD_MULTI_FLAG_SKIP_UTF8_BOM  &&  sizeof(MD_CHAR) == 1) {
+            static const MD_CHAR bom[3] = { (char)0xef, (char)0xbb, (char)0xbf };
+            if(input_size >= sizeof(bom)  &&  memcmp(input, bom, sizeof(bom)) == 0) {
+                input += sizeof(bom);
+                input_size -= sizeof(bom);
+            }
+        }
+
+#ifndef MD4X_TRACE
+        /* A single target needs no fan-out: call its callbacks directly.
+         * (Trace builds keep the fan-out for its per-target events.) */
+        if(m.n == 1) {
+            parser = m.parsers[0];
+            parser.flags = parser_flags;
+            userdata = m.ctxs[0];
+        }
+#endif
+
+        ret = md_parse_ex(input, input_size, &parser, userdata, limits, stats);
+    }
+
+    /* Finish every renderer (this also releases its resources). */
+    for(i = 0; i < m.n; i++) {
+        end_ret = m.hooks[i]->end(m.ctxs[i], ret);
+        if(end_ret != 0  &&  ret == 0)
+            ret = end_ret;
+        free(m.ctxs[i]);
+    }
+
+    return ret;
+}
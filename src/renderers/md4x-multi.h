@@ -0,0 +1,95 @@
+/*
+ * MD4X: Markdown parser for C
+ * (http://github.com/unjs/md4x)
+ *
+ * Copyright (c) 2026 Pooya Parsa <pooya@pi0.io>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MD4X_MULTI_H
+#define MD4X_MULTI_H
+
+#include "md4x.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define MD_MULTI_FLAG_SKIP_UTF8_BOM 0x0002
+#define MD_MULTI_FLAG_HEAL 0x0100
+
+/* Maximum number of targets per md_render_multi() call. */
+#define MD_MULTI_MAX_TARGETS 8
+
+    typedef enum MD_RENDER_FORMAT
+    {
+        MD_RENDER_HTML = 0,
+        MD_RENDER_AST,
+        MD_RENDER_META,
+        MD_RENDER_TEXT,
+        MD_RENDER_ANSI,
+        MD_RENDER_MARKDOWN
+    } MD_RENDER_FORMAT;
+
+    typedef struct MD_RENDER_TARGET
+    {
+        MD_RENDER_FORMAT format;
+        /* Bitmask of MD_HTML_FLAG_xxxx, MD_AST_FLAG_xxxx, ... for the format.
+         * The per-renderer HEAL and SKIP_UTF8_BOM flags are ignored; pass
+         * MD_MULTI_FLAG_xxxx to md_render_multi() instead. */
+        unsigned renderer_flags;
+        void (*process_output)(const MD_CHAR *, MD_SIZE, void *);
+        void *userdata;
+    } MD_RENDER_TARGET;
+
+    /* Render Markdown into several formats with a single md_parse().
+     *
+     * Every parser callback is dispatched to each target's renderer in turn,
+     * and each renderer writes to its own process_output() sink. The result
+     * is identical to calling md_html(), md_ast(), md_meta(), md_text(),
+     * md_ansi() and md_markdown() separately, but the input is parsed (and frontmatter converted) once.
+     *
+     * Param parser_flags are flags from md4x.h propagated to md_parse().
+     * Param flags is bitmask of MD_MULTI_FLAG_xxxx and applies to all
+     * targets (e.g. healing happens once, before the shared parse).
+     *
+     * If limits is not NULL, it is passed to md_parse_ex(): when the
+     * document exceeds them, MD_LIMIT_EXCEEDED is returned.
+     *
+     * If stats is not NULL, it is filled by md_parse_ex(); its emit time then
+     * includes the time spent in the renderers. With no targets (n_targets
+     * is 0), the document is only parsed, e.g. to collect the stats.
+     *
+     * Returns -1 on error (if md_parse() or any renderer fails, or
+     * n_targets is out of range), or MD_LIMIT_EXCEEDED. Outputs of other targets are then
+     * incomplete and should be discarded.
+     * Returns 0 on success.
+     */
+    int md_render_multi(const MD_CHAR *input, MD_SIZE input_size,
+                        const MD_RENDER_TARGET *targets, int n_targets,
+                        unsigned parser_flags, unsigned flags,
+                        const MD_LIMITS *limits, MD_PARSE_STATS *stats);
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+
+#endif /* MD4X_MULTI_H */
@@ -0,0 +1,60 @@
+/*
+ * MD4X: Markdown parser for C
+ * (http://github.com/unjs/md4x)
+ *
+ * Copyright (c) 2026 Pooya Parsa <pooya@pi0.io>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Renderer hooks shared with md_render_multi() (internal, not installed).
+ * Each renderer that can take part in a shared md_parse() exports one
+ * MD_RENDER_HOOKS describing how to set up and finish its context.
+ */
+
+#ifndef MD4X_RENDER_H
+#define MD4X_RENDER_H
+
+#include <stddef.h>
+#include "md4x.h"
+
+typedef struct MD_RENDER_HOOKS
+{
+    /* Size of the renderer context; the caller allocates it. */
+    size_t ctx_size;
+
+    /* Initialize ctx and install the renderer callbacks (and debug_log) into
+     * parser. parser->flags is left to the caller. */
+    void (*begin)(void *ctx, MD_PARSER *parser,
+                  void (*process_output)(const MD_CHAR *, MD_SIZE, void *),
+                  void *userdata, unsigned renderer_flags);
+
+    /* Called with the md_parse() return value. Emits output that needs the
+     * whole document, releases ctx resources and returns the final status. */
+    int (*end)(void *ctx, int ret);
+} MD_RENDER_HOOKS;
+
+extern const MD_RENDER_HOOKS md_html_render_hooks;
+extern const MD_RENDER_HOOKS md_ast_render_hooks;
+extern const MD_RENDER_HOOKS md_meta_render_hooks;
+extern const MD_RENDER_HOOKS md_text_render_hooks;
+extern const MD_RENDER_HOOKS md_ansi_render_hooks;
+extern const MD_RENDER_HOOKS md_markdown_render_hooks;
+
+#endif /* MD4X_RENDER_H */
@@ -28,6 +28,7 @@
 
 #include "md4x-text.h"
 #include "md4x-heal-wrap.h"
+#include "md4x-render.h"
 #include "entity.h"
 
 
@@ -539,6 +540,37 @@ debug_log_callback(const char* msg, void* userdata)
         fprintf(stderr, "MD4X: %s\n", msg);
 }
 
+static void
+text_begin(void* ctx, MD_PARSER* parser,
+           void (*process_output)(const MD_CHAR*, MD_SIZE, void*),
+           void* userdata, unsigned renderer_flags)
+{
+    MD_TEXT* r = (MD_TEXT*) ctx;
+
+    memset(r, 0, sizeof(MD_TEXT));
+    r->process_output = process_output;
+    r->userdata = userdata;
+    r->flags = renderer_flags;
+
+    parser->enter_block = enter_block_callback;
+    parser->leave_block = leave_block_callback;
+    parser->enter_span = enter_span_callback;
+    parser->leave_span = leave_span_callback;
+    parser->text = text_callback;
+    parser->debug_log = debug_log_callback;
+}
+
+static int
+text_end(void* ctx, int ret)
+{
+    (void) ctx;
+    return ret;
+}
+
+const MD_RENDER_HOOKS md_text_render_hooks = {
+    sizeof(MD_TEXT), text_begin, text_end
+};
+
 int
 md_text(const MD_CHAR* input, MD_SIZE input_size,
         void (*process_output)(const MD_CHAR*, MD_SIZE, void*),
@@ -562,18 +594,8 @@ md_text(const MD_CHAR* input, MD_SIZE input_size,
     }
 
     memset(&parser, 0, sizeof(parser));
+    text_begin(&render, &parser, process_output, userdata, renderer_flags);
     parser.flags = parser_flags;
-    parser.enter_block = enter_block_callback;
-    parser.leave_block = leave_block_callback;
-    parser.enter_span = enter_span_callback;
-    parser.leave_span = leave_span_callback;
-    parser.text = text_callback;
-    parser.debug_log = debug_log_callback;
-
-    memset(&render, 0, sizeof(render));
-    render.process_output = process_output;
-    render.userdata = userdata;
-    render.flags = renderer_flags;
 
     /* Consider skipping UTF-8 byte order mark (BOM). */
     if(renderer_flags & MD_TEXT_FLAG_SKIP_UTF8_BOM  &&  sizeof(MD_CHAR) == 1) {
@@ -584,5 +606,5 @@ md_text(const MD_CHAR* input, MD_SIZE input_size,
         }
     }
 
-    return md_parse(input, input_size, &parser, (void*) &render);
+    return text_end(&render, md_parse(input, input_size, &parser, (void*) &render));
 }
@@ -0,0 +1,316 @@
+/*
+ * MD4X: Markdown parser for C
+ * (http://github.com/unjs/md4x)
+ *
+ * Copyright (c) 2026 Pooya Parsa <pooya@pi0.io>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Flat YAML frontmatter scanner
+ *
+ * Fast path for the common frontmatter shape, used before falling back to
+ * libyaml (see json_write_yaml_props() in md4x-json.h).
+ */
+
+#ifndef MD4X_YAML_H
+#define MD4X_YAML_H
+
+#include <string.h>
+#include "md4x.h"
+
+/* Most frontmatter is a flat mapping of `key: scalar` lines, optionally with
+ * simple `- item` lists. yaml_fast_scan() recognizes exactly that subset
+ * without libyaml and without allocating. Anything else (nested mappings,
+ * flow collections, block scalars, anchors, tags, comments after values,
+ * escapes in quoted strings, ...) makes it fail so the caller falls back to
+ * libyaml. For accepted input the result matches libyaml's events. */
+
+#define YAML_FAST_MAX_ENTRIES 64
+#define YAML_FAST_MAX_ITEMS 128
+#define YAML_FAST_MAX_KEY 255
+
+typedef struct
+{
+    const char *str;
+    MD_SIZE size;
+    int quoted;
+} YAML_FAST_SCALAR;
+
+typedef struct
+{
+    YAML_FAST_SCALAR key;
+    YAML_FAST_SCALAR value; /* Used when n_items < 0. */
+    int first_item;         /* Index into YAML_FAST_DOC.items. */
+    int n_items;            /* -1 for a scalar value, otherwise list length. */
+    int item_indent;
+} YAML_FAST_ENTRY;
+
+typedef struct
+{
+    YAML_FAST_ENTRY entries[YAML_FAST_MAX_ENTRIES];
+    YAML_FAST_SCALAR items[YAML_FAST_MAX_ITEMS];
+    int n_entries;
+    int n_items;
+} YAML_FAST_DOC;
+
+/* Check [s, s+len) holds only printable characters libyaml accepts
+ * unchanged: no control characters or tabs, well-formed UTF-8, and none of
+ * the non-printable or line-break code points (C1 controls, NEL, LS/PS, BOM,
+ * surrogates, U+FFFE/U+FFFF). */
+static int
+yaml_fast_text_ok(const char *s, MD_SIZE len)
+{
+    const unsigned char *p = (const unsigned char *)s;
+    MD_SIZE i = 0;
+
+    while (i < len)
+    {
+        unsigned c = p[i];
+        unsigned cp;
+        MD_SIZE n, k;
+
+        if (c < 0x80)
+        {
+            if (c < 0x20 || c == 0x7f)
+                return 0;
+            i++;
+            continue;
+        }
+
+        if (c >= 0xc2 && c <= 0xdf)
+        {
+            n = 1;
+            cp = c & 0x1f;
+        }
+        else if (c >= 0xe0 && c <= 0xef)
+        {
+            n = 2;
+            cp = c & 0x0f;
+        }
+        else if (c >= 0xf0 && c <= 0xf4)
+        {
+            n = 3;
+            cp = c & 0x07;
+        }
+        else
+        {
+            return 0;
+        }
+        if (i + n >= len)
+            return 0;
+        for (k = 1; k <= n; k++)
+        {
+            if ((p[i + k] & 0xc0) != 0x80)
+                return 0;
+            cp = (cp << 6) | (p[i + k] & 0x3f);
+        }
+        if ((n == 2 && cp < 0x800) || (n == 3 && (cp < 0x10000 || cp > 0x10ffff)))
+            return 0;
+        if (cp < 0xa0 || cp == 0x2028 || cp == 0x2029 || cp == 0xfeff ||
+            (cp >= 0xd800 && cp <= 0xdfff) || cp == 0xfffe || cp == 0xffff)
+            return 0;
+        i += n + 1;
+    }
+    return 1;
+}
+
+/* Check a full-line comment the way libyaml reads it: like
+ * yaml_fast_text_ok(), but tabs are allowed. Any other control character,
+ * CR, NEL or LS/PS (a line break to libyaml, so the comment would end there)
+ * or invalid UTF-8 sends the document to libyaml. */
+static int
+yaml_fast_comment_ok(const char *s, MD_SIZE len)
+{
+    MD_SIZE start = 0;
+    MD_SIZE i;
+
+    for (i = 0; i <= len; i++)
+    {
+        if (i == len || s[i] == '\t')
+        {
+            if (!yaml_fast_text_ok(s + start, i - start))
+                return 0;
+            start = i + 1;
+        }
+    }
+    return 1;
+}
+
+/* Parse a single-line scalar value (leading/trailing spaces already trimmed). */
+static int
+yaml_fast_scalar(const char *s, MD_SIZE len, YAML_FAST_SCALAR *out)
+{
+    MD_SIZE i;
+
+    if (!yaml_fast_text_ok(s, len))
+        return -1;
+
+    out->quoted = 0;
+    out->str = s;
+    out->size = len;
+    if (len == 0)
+        return 0;
+
+    /* Quoted: no escapes, no embedded quotes, nothing after the closing quote. */
+    if (s[0] == '"' || s[0] == '\'')
+    {
+        if (len < 2 || s[len - 1] != s[0])
+            return -1;
+        for (i = 1; i < len - 1; i++)
+        {
+            if (s[i] == s[0] || s[i] == '\\')
+                return -1;
+        }
+        out->quoted = 1;
+        out->str = s + 1;
+        out->size = len - 2;
+        return 0;
+    }
+
+    /* Plain: reject indicators that start other node kinds. */
+    if (strchr(",[]{}#&*!|>%@`", s[0]) != NULL)
+        return -1;
+    if ((s[0] == '-' || s[0] == '?' || s[0] == ':') && (len == 1 || s[1] == ' '))
+        return -1;
+
+    /* Reject mapping separators and comments inside the value. */
+    if (s[len - 1] == ':')
+        return -1;
+    for (i = 0; i + 1 < len; i++)
+    {
+        if ((s[i] == ':' && s[i + 1] == ' ') || (s[i] == ' ' && s[i + 1] == '#'))
+            return -1;
+    }
+    return 0;
+}
+
+/* Scan a flat YAML mapping into doc. Returns 0 if the whole input was
+ * understood, -1 if the caller must fall back to libyaml. */
+static int
+yaml_fast_scan(const char *text, MD_SIZE size, YAML_FAST_DOC *doc)
+{
+    MD_SIZE pos = 0;
+    YAML_FAST_ENTRY *cur = NULL;
+
+    doc->n_entries = 0;
+    doc->n_items = 0;
+
+    while (pos < size)
+    {
+        const char *line = text + pos;
+        MD_SIZE eol = pos;
+        MD_SIZE len, i, indent;
+
+        while (eol < size && text[eol] != '\n')
+            eol++;
+        len = eol - pos;
+        pos = eol + 1;
+        if (len > 0 && line[len - 1] == '\r')
+            len--;
+
+        /* Skip blank lines and full-line comments. */
+        indent = 0;
+        while (indent < len && line[indent] == ' ')
+            indent++;
+        if (indent == len)
+            continue;
+        if (line[indent] == '#')
+        {
+            if (!yaml_fast_comment_ok(line + indent, len - indent))
+                return -1;
+            continue;
+        }
+
+        /* List item belonging to the current `key:` entry. */
+        if (line[indent] == '-' && (indent + 1 == len || line[indent + 1] == ' '))
+        {
+            YAML_FAST_SCALAR *item;
+
+            if (cur == NULL || (cur->n_items < 0 && cur->value.size > 0) || cur->value.quoted)
+                return -1;
+            if (cur->n_items < 0)
+            {
+                cur->n_items = 0;
+                cur->first_item = doc->n_items;
+                cur->item_indent = (int)indent;
+            }
+            else if (cur->item_indent != (int)indent)
+            {
+                return -1;
+            }
+            if (doc->n_items >= YAML_FAST_MAX_ITEMS)
+                return -1;
+
+            i = indent + 1;
+            while (i < len && line[i] == ' ')
+                i++;
+            while (len > i && line[len - 1] == ' ')
+                len--;
+            item = &doc->items[doc->n_items];
+            /* Empty items and nested nodes are left to libyaml. */
+            if (i == len || yaml_fast_scalar(line + i, len - i, item) != 0)
+                return -1;
+            doc->n_items++;
+            cur->n_items++;
+            continue;
+        }
+
+        /* Anything else indented (nested mapping, continuation) is unsupported. */
+        if (indent > 0)
+            return -1;
+
+        /* `key:` or `key: value` */
+        if (!((line[0] >= 'A' && line[0] <= 'Z') || (line[0] >= 'a' && line[0] <= 'z') ||
+              (line[0] >= '0' && line[0] <= '9') || line[0] == '_'))
+            return -1;
+        for (i = 1; i < len && line[i] != ':'; i++)
+        {
+            char c = line[i];
+            if (!((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') ||
+                  (c >= '0' && c <= '9') || c == '_' || c == '-' || c == '.'))
+                return -1;
+        }
+        if (i == len || i > YAML_FAST_MAX_KEY || (i + 1 < len && line[i + 1] != ' '))
+            return -1;
+        if (doc->n_entries >= YAML_FAST_MAX_ENTRIES)
+            return -1;
+
+        cur = &doc->entries[doc->n_entries++];
+        cur->key.str = line;
+        cur->key.size = i;
+        cur->key.quoted = 0;
+        cur->n_items = -1;
+        cur->first_item = 0;
+        cur->item_indent = 0;
+
+        i++;
+        while (i < len && line[i] == ' ')
+            i++;
+        while (len > i && line[len - 1] == ' ')
+            len--;
+        if (yaml_fast_scalar(line + i, len - i, &cur->value) != 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+#endif /* MD4X_YAML_H */
@@ -0,0 +1,48 @@
+/*
+ * MD4X: Markdown parser for C
+ * (http://github.com/unjs/md4x)
+ *
+ * Copyright (c) 2026 Pooya Parsa <pooya@pi0.io>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Allocation counting for the benchmark harness.
+ *
+ * The parser, renderers and libyaml are compiled with
+ * `-include bench-alloc.h`, so their malloc()/calloc()/realloc() calls go
+ * through the counting wrappers defined in md4x-bench.c.
+ */
+
+#ifndef MD4X_BENCH_ALLOC_H
+#define MD4X_BENCH_ALLOC_H
+
+#include <stdlib.h>
+#include <string.h>
+
+void* bench_malloc(size_t size);
+void* bench_calloc(size_t n, size_t size);
+void* bench_realloc(void* ptr, size_t size);
+
+#define malloc(size)        bench_malloc(size)
+#define calloc(n, size)     bench_calloc(n, size)
+#define realloc(ptr, size)  bench_realloc(ptr, size)
+
+#endif /* MD4X_BENCH_ALLOC_H */
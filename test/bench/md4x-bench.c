@@ -0,0 +1,1565 @@
+/*
+ * MD4X: Markdown parser for C
+ * (http://github.com/unjs/md4x)
+ *
+ * Copyright (c) 2026 Pooya Parsa <pooya@pi0.io>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Native benchmark harness for the MD4X parser and renderers.
+ *
+ * Runs every renderer over a fixed corpus (the test/spec*.txt examples,
+ * synthetic large documents and the pathological inputs) and reports MB/s
+ * and allocations per run. Results are compared with a saved baseline, and
+ * the harness exits with status 1 when any result regresses by more than the
+ * tolerance.
+ *
+ * Usage (from the repository root; `zig build bench -- ARGS` does the same):
+ *   md4x-bench                            # compare with test/bench/baseline.json
+ *   md4x-bench --save=test/bench/baseline.json   # record a new baseline
+ *   md4x-bench --baseline=FILE --tolerance=0.2 --min-time=0.2
+ *   md4x-bench --filter=table             # only corpus/renderer names containing it
+ *   md4x-bench --scaling                  # check the growth rate of render times
+ *
+ * The corpus is generated deterministically. Its layout is versioned by
+ * BENCH_CORPUS_VERSION; baselines recorded for another version are ignored.
+ * Throughput depends on the machine, so refresh the baseline (--save) on the
+ * machine the comparison runs on.
+ *
+ * The scaling check (--scaling) renders each pathological and extension
+ * syntax family at four sizes instead, and fails when any renderer's time
+ * grows worse than about linearithmically with the input size. It needs no
+ * baseline.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "md4x.h"
+#include "md4x-html.h"
+#include "md4x-ast.h"
+#include "md4x-ansi.h"
+#include "md4x-meta.h"
+#include "md4x-text.h"
+#include "md4x-markdown.h"
+#include "md4x-heal.h"
+
+
+#define BENCH_CORPUS_VERSION    1
+
+
+/****************************
+ ***  Allocation counting ***
+ ****************************/
+
+static unsigned long bench_n_allocs = 0;
+
+void*
+bench_malloc(size_t size)
+{
+    bench_n_allocs++;
+    return malloc(size);
+}
+
+void*
+bench_calloc(size_t n, size_t size)
+{
+    bench_n_allocs++;
+    return calloc(n, size);
+}
+
+void*
+bench_realloc(void* ptr, size_t size)
+{
+    bench_n_allocs++;
+    return realloc(ptr, size);
+}
+
+
+/***************************
+ ***  Grow-able buffer   ***
+ ***************************/
+
+typedef struct {
+    char* data;
+    size_t size;
+    size_t asize;
+} BUF;
+
+static void
+buf_append(BUF* buf, const char* data, size_t size)
+{
+    if(buf->size + size > buf->asize) {
+        buf->asize = buf->asize + buf->asize / 2 + size + 1024;
+        buf->data = realloc(buf->data, buf->asize);
+        if(buf->data == NULL) {
+            fprintf(stderr, "buf_append: realloc() failed.\n");
+            exit(1);
+        }
+    }
+    memcpy(buf->data + buf->size, data, size);
+    buf->size += size;
+}
+
+static void
+buf_puts(BUF* buf, const char* str)
+{
+    buf_append(buf, str, strlen(str));
+}
+
+static void
+buf_printf(BUF* buf, const char* fmt, int a, int b)
+{
+    char tmp[256];
+    int n = snprintf(tmp, sizeof(tmp), fmt, a, b);
+    buf_append(buf, tmp, (size_t) n);
+}
+
+static void
+buf_repeat(BUF* buf, const char* str, int count)
+{
+    int i;
+    for(i = 0; i < count; i++)
+        buf_puts(buf, str);
+}
+
+
+/**********************
+ ***  The corpus    ***
+ **********************/
+
+/* A corpus entry is one or more documents measured together. */
+typedef struct {
+    const char* name;
+    BUF* docs;
+    int n_docs;
+    size_t bytes;
+} CORPUS;
+
+#define MAX_CORPORA     64
+
+static CORPUS corpora[MAX_CORPORA];
+static int n_corpora = 0;
+
+/* Deterministic pseudo-random numbers (LCG), so the corpus never changes. */
+static unsigned bench_seed = 12345;
+
+static int
+rnd(int n)
+{
+    bench_seed = bench_seed * 1103515245u + 12345u;
+    return (int) ((bench_seed >> 16) % (unsigned) n);
+}
+
+static CORPUS*
+corpus_new(const char* name)
+{
+    CORPUS* c;
+
+    if(n_corpora >= MAX_CORPORA) {
+        fprintf(stderr, "Too many corpora.\n");
+        exit(1);
+    }
+    c = &corpora[n_corpora++];
+    c->name = name;
+    c->docs = NULL;
+    c->n_docs = 0;
+    c->bytes = 0;
+    return c;
+}
+
+static BUF*
+corpus_add_doc(CORPUS* c)
+{
+    c->docs = realloc(c->docs, (c->n_docs + 1) * sizeof(BUF));
+    if(c->docs == NULL) {
+        fprintf(stderr, "corpus_add_doc: realloc() failed.\n");
+        exit(1);
+    }
+    memset(&c->docs[c->n_docs], 0, sizeof(BUF));
+    return &c->docs[c->n_docs++];
+}
+
+static void
+corpus_finish(CORPUS* c)
+{
+    int i;
+    for(i = 0; i < c->n_docs; i++)
+        c->bytes += c->docs[i].size;
+}
+
+/* All examples of the test/spec*.txt files, each as a separate document. */
+static void
+gen_spec(const char* root)
+{
+    static const char* files[] = {
+        "spec.txt", "spec-alerts.txt", "spec-attributes.txt", "spec-components.txt",
+        "spec-frontmatter.txt", "spec-hard-soft-breaks.txt", "spec-latex-math.txt",
+        "spec-markdown.txt", "spec-permissive-autolinks.txt", "spec-strikethrough.txt",
+        "spec-tables.txt", "spec-tasklists.txt", "spec-underline.txt", "spec-wiki-links.txt",
+        NULL
+    };
+    static const char fence[] = "```````````````````````````````` example";
+    CORPUS* c = corpus_new("spec");
+    char path[1024];
+    char line[4096];
+    BUF* doc = NULL;
+    int i;
+
+    for(i = 0; files[i] != NULL; i++) {
+        FILE* f;
+        int state = 0;     /* 0 = prose, 1 = example input, 2 = expected output */
+
+        snprintf(path, sizeof(path), "%s/test/%s", root, files[i]);
+        f = fopen(path, "rb");
+        if(f == NULL) {
+            fprintf(stderr, "Cannot open %s (run from the repository root or pass --root).\n", path);
+            exit(1);
+        }
+        while(fgets(line, sizeof(line), f) != NULL) {
+            if(state == 0  &&  strncmp(line, fence, sizeof(fence) - 1) == 0) {
+                doc = corpus_add_doc(c);
+                state = 1;
+            } else if(state == 1  &&  strcmp(line, ".\n") == 0) {
+                state = 2;
+            } else if(state == 2  &&  strncmp(line, "````````````````````````````````", 32) == 0) {
+                state = 0;
+            } else if(state == 1) {
+                /* The spec files show tabs as U+2192. */
+                char* p = line;
+                char* arrow;
+                while((arrow = strstr(p, "\xe2\x86\x92")) != NULL) {
+                    buf_append(doc, p, (size_t) (arrow - p));
+                    buf_append(doc, "\t", 1);
+                    p = arrow + 3;
+                }
+                buf_puts(doc, p);
+            }
+        }
+        fclose(f);
+    }
+    corpus_finish(c);
+}
+
+static void
+gen_docs(void)
+{
+    CORPUS* c = corpus_new("docs");
+    BUF* b;
+    int d, i;
+
+    /* Many small documentation pages with frontmatter and components. */
+    for(d = 0; d < 200; d++) {
+        b = corpus_add_doc(c);
+        buf_printf(b, "---\ntitle: Page %d\ndescription: About topic %d\nnavigation: true\n---\n\n", d, d);
+        buf_printf(b, "# Page %d\n\nThis page explains **topic %d** in detail.\n\n", d, d);
+        for(i = 0; i < 6; i++) {
+            buf_printf(b, "## Section %d.%d\n\n", d, i);
+            buf_puts(b, "Some *emphasized* text, `inline code`, a [link](https://example.com/docs) "
+                        "and ~~removed~~ words. More prose follows here to make the\n"
+                        "paragraph span multiple lines like real documentation does.\n\n");
+            buf_puts(b, "- First item\n- Second item with **bold**\n  - Nested item\n\n");
+            if(i % 2 == 0)
+                buf_puts(b, "::callout{icon=\"i-lucide-info\" color=\"primary\"}\nRemember to check the **config**.\n::\n\n");
+            if(i % 3 == 0)
+                buf_puts(b, "```ts [nuxt.config.ts]\nexport default defineNuxtConfig({\n  modules: ['@nuxt/content'],\n})\n```\n\n");
+        }
+    }
+    corpus_finish(c);
+}
+
+static void
+gen_deep_lists(void)
+{
+    CORPUS* c = corpus_new("deep-lists");
+    BUF* b = corpus_add_doc(c);
+    int r, depth;
+
+    for(r = 0; r < 400; r++) {
+        for(depth = 0; depth < 16; depth++) {
+            buf_repeat(b, "  ", depth);
+            buf_puts(b, (depth % 2) ? "1. " : "- ");
+            buf_printf(b, "item %d at depth %d with *emphasis*\n", r, depth);
+        }
+        buf_puts(b, "\n");
+    }
+    corpus_finish(c);
+}
+
+static void
+gen_huge_table(void)
+{
+    CORPUS* c = corpus_new("huge-table");
+    BUF* b = corpus_add_doc(c);
+    int r;
+
+    buf_puts(b, "| Name | Type | Default | Description | Since | Notes |\n");
+    buf_puts(b, "|:-----|:----:|--------:|-------------|-------|-------|\n");
+    for(r = 0; r < 20000; r++) {
+        buf_printf(b, "| `option%d` | **string** | `\"v%d\"` |", r, r % 7);
+        buf_printf(b, " Sets the value of option %d, see [docs](#o%d). |", r, r);
+        buf_printf(b, " v%d.%d | *none* |\n", r % 5, r % 10);
+    }
+    corpus_finish(c);
+
+    /* 100k data rows without links: cell boundaries come from the cheap pipe
+     * scan, so the inline analysis runs only once per cell. */
+    c = corpus_new("table-100k-rows");
+    b = corpus_add_doc(c);
+    buf_puts(b, "| id | key | value | flags |\n");
+    buf_puts(b, "|---:|-----|-------|:-----:|\n");
+    for(r = 0; r < 100000; r++) {
+        buf_printf(b, "| %d | `k%d` |", r, r % 97);
+        buf_printf(b, " value %d with *emphasis* | `a\\|b` %d |\n", r, r % 3);
+    }
+    corpus_finish(c);
+}
+
+static void
+gen_prose(void)
+{
+    static const char* sentences[] = {
+        "The meeting starts at 10:30 and ends at 12:00. ",
+        "Note: the results were mixed, e.g. for the second batch. ",
+        "Contact the team at support@example.com or visit www.example.com today. ",
+        "See http://example.com/guide for details. ",
+        "Ratio 3:2 was used; see Fig. 4, p. 17 and vol. 2. ",
+        "It worked. Then it did not. Why? Nobody knows... ",
+        "Mr. Smith et al. wrote about it in ch. 3: \"Parsing\". ",
+        "Key points: speed, memory, and correctness. "
+    };
+    static const char* snippets[] = {
+        "word ", "*emph* ", "**strong** ", "`code` ", "[link](/u) ",
+        "a_b ", "x*y ", "~~del~~ ", "&amp; ", "[ref] "
+    };
+    CORPUS* c = corpus_new("prose");
+    BUF* b = corpus_add_doc(c);
+    int p, i;
+
+    /* Plain paragraphs full of periods, colons and the occasional autolink. */
+    for(p = 0; p < 3000; p++) {
+        for(i = 0; i < 6; i++)
+            buf_puts(b, sentences[(p * 5 + i * 3) % 8]);
+        buf_puts(b, "\n\n");
+    }
+    corpus_finish(c);
+
+    /* A single 1.5 MB paragraph dense with inline marks, so that the mark
+     * array of one block is far larger than the CPU caches. */
+    c = corpus_new("long-paragraph");
+    b = corpus_add_doc(c);
+    for(i = 0; i < 200000; i++)
+        buf_puts(b, snippets[(i * 7 + i / 13) % 10]);
+    buf_puts(b, "\n");
+    corpus_finish(c);
+}
+
+static void
+gen_entity_dense(void)
+{
+    static const char* entities[] = {
+        "&amp;", "&lt;", "&gt;", "&quot;", "&copy;", "&nbsp;", "&mdash;", "&hellip;",
+        "&#123;", "&#x1F600;", "&#x27;", "&eacute;", "&Auml;", "&frac12;", "&rarr;", "&bogus;"
+    };
+    CORPUS* c = corpus_new("entity-dense");
+    BUF* b = corpus_add_doc(c);
+    int i;
+
+    for(i = 0; i < 60000; i++) {
+        buf_puts(b, entities[rnd(16)]);
+        buf_puts(b, (i % 12 == 11) ? "\n" : " x ");
+        if(i % 120 == 119)
+            buf_puts(b, "\n");
+    }
+    corpus_finish(c);
+}
+
+static void
+gen_cjk(void)
+{
+    static const char* words[] = {
+        "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e",                 /* 日本語 */
+        "\xe4\xb8\xad\xe6\x96\x87",                             /* 中文 */
+        "\xed\x95\x9c\xea\xb5\xad\xec\x96\xb4",                 /* 한국어 */
+        "\xe3\x83\x86\xe3\x82\xb9\xe3\x83\x88",                 /* テスト */
+        "\xe6\x96\x87\xe7\xab\xa0",                             /* 文章 */
+        "\xe3\x80\x81",                                         /* 、 */
+        "\xe3\x80\x82",                                         /* 。 */
+        "\xef\xbc\x88\xe6\xb3\xa8\xef\xbc\x89",                 /* （注） */
+    };
+    CORPUS* c = corpus_new("cjk");
+    BUF* b = corpus_add_doc(c);
+    int i, p;
+
+    for(p = 0; p < 3000; p++) {
+        if(p % 10 == 0)
+            buf_printf(b, "## \xe7\xac\xac%d\xe7\xab\xa0 %d\n\n", p / 10, p);
+        for(i = 0; i < 24; i++) {
+            int k = rnd(12);
+            if(k == 8)
+                buf_puts(b, "**");
+            buf_puts(b, words[rnd(8)]);
+            if(k == 8)
+                buf_puts(b, "**");
+            else if(k == 9)
+                buf_puts(b, "*\xe5\xbc\xb7\xe8\xaa\xbf*");
+        }
+        buf_puts(b, "\n\n");
+    }
+    corpus_finish(c);
+}
+
+static void
+gen_code_heavy(void)
+{
+    CORPUS* c = corpus_new("code-heavy");
+    BUF* b = corpus_add_doc(c);
+    int i, j;
+
+    for(i = 0; i < 1500; i++) {
+        buf_printf(b, "Call `fn_%d()` or `obj.method(%d)` before ``a `quoted` span``.\n\n", i, i);
+        if(i % 3 == 0) {
+            buf_printf(b, "```c {%d-%d} [main.c]\n", 1 + i % 4, 3 + i % 4);
+            for(j = 0; j < 12; j++)
+                buf_printf(b, "    int v%d = compute(%d, &ctx) << 2; /* <tag> & \"str\" */\n", j, i);
+            buf_puts(b, "```\n\n");
+        } else if(i % 3 == 1) {
+            for(j = 0; j < 8; j++)
+                buf_printf(b, "    line_%d = value_%d * 2\n", j, i);
+            buf_puts(b, "\n");
+        } else {
+            buf_puts(b, "~~~~ js\nconst x = { a: 1, b: [1, 2, 3] };\nconsole.log(`${x.a}`);\n~~~~\n\n");
+        }
+    }
+    corpus_finish(c);
+}
+
+/* MDX-like content: HTML blocks of all start conditions between short
+ * paragraphs, most of them starting with tags that are not type 6 tags. */
+static void
+gen_html_heavy(void)
+{
+    static const char* blocks[] = {
+        "<div class=\"note\">\n\n*text*\n\n</div>\n",
+        "<Callout type=\"info\" title=\"T\">\nBody line.\n</Callout>\n",
+        "<section id=\"s\">\n<p>para</p>\n</section>\n",
+        "<script type=\"module\">\nconst a = 1 < 2;\n\nrun(a);\n</script>\n",
+        "<!-- comment\nspanning lines -->\n",
+        "<MyComponent prop={1} other=\"x\" />\n",
+        "<textarea>\nraw\n\ntext\n</textarea>\n",
+        "<table><tr><td>cell</td></tr></table>\n",
+        "<thead-like attr>\n",
+        "<Tabs>\n<TabItem value=\"a\">\nA\n</TabItem>\n</Tabs>\n"
+    };
+    CORPUS* c = corpus_new("html-heavy");
+    BUF* b = corpus_add_doc(c);
+    int i;
+
+    for(i = 0; i < 20000; i++) {
+        buf_puts(b, blocks[(i * 7) % 10]);
+        buf_printf(b, "\nParagraph %d with <span>inline</span> HTML, see %d.\n\n", i, i % 100);
+    }
+    corpus_finish(c);
+}
+
+static void
+gen_link_ref_heavy(void)
+{
+    CORPUS* c = corpus_new("link-ref-heavy");
+    BUF* b = corpus_add_doc(c);
+    int i;
+
+    for(i = 0; i < 6000; i++) {
+        buf_printf(b, "See [ref %d][r%d], ", i, rnd(5000));
+        buf_printf(b, "[Ref%d] and <https://example.com/p/%d>, ", rnd(5000), i);
+        buf_printf(b, "also https://www.example.org/%d/x and [inline](/u/%d \"T\").\n\n", i, i);
+    }
+    for(i = 0; i < 5000; i++)
+        buf_printf(b, "[r%d]: https://example.com/ref/%d \"Title\"\n", i, i);
+    corpus_finish(c);
+
+    /* Generated API docs: 10k definitions, 100k references to them with a
+     * different letter case. Labels and destinations are kept short so that
+     * every reference stays under the ref. definition output cap. */
+    c = corpus_new("ref-defs-10k");
+    b = corpus_add_doc(c);
+    for(i = 0; i < 100000; i++) {
+        buf_printf(b, (i % 2) ? "Returns [T %d], see %d." : "Returns [t %d], see %d.",
+                   (i * 7919) % 10000, i);
+        buf_puts(b, (i % 5 == 4) ? "\n\n" : "\n");
+    }
+    buf_puts(b, "\n");
+    for(i = 0; i < 10000; i++)
+        buf_printf(b, "[T  %d]: #%d\n", i, i % 10);
+    corpus_finish(c);
+}
+
+/* The inputs of test/pathological-tests.py that stress the parser the most. */
+static void
+gen_pathological(void)
+{
+    CORPUS* c;
+    BUF* b;
+    int i;
+
+    c = corpus_new("patho-nested-emph");
+    b = corpus_add_doc(c);
+    buf_repeat(b, "*a **a ", 65000);
+    buf_puts(b, "b");
+    buf_repeat(b, " a** a*", 65000);
+    corpus_finish(c);
+
+    c = corpus_new("patho-emph-openers");
+    b = corpus_add_doc(c);
+    buf_repeat(b, "_a ", 65000);
+    corpus_finish(c);
+
+    c = corpus_new("patho-link-openers");
+    b = corpus_add_doc(c);
+    buf_repeat(b, "[a", 65000);
+    corpus_finish(c);
+
+    c = corpus_new("patho-nested-brackets");
+    b = corpus_add_doc(c);
+    buf_repeat(b, "[", 50000);
+    buf_puts(b, "a");
+    buf_repeat(b, "]", 50000);
+    corpus_finish(c);
+
+    c = corpus_new("patho-nested-quotes");
+    b = corpus_add_doc(c);
+    buf_repeat(b, "> ", 50000);
+    buf_puts(b, "a");
+    corpus_finish(c);
+
+    c = corpus_new("patho-many-refs");
+    b = corpus_add_doc(c);
+    for(i = 1; i < 20000 * 16; i++)
+        buf_printf(b, "[%d]: u%.0d\n", i, 0);
+    buf_repeat(b, "[0] ", 20000);
+    corpus_finish(c);
+
+    c = corpus_new("patho-nested-lists");
+    b = corpus_add_doc(c);
+    for(i = 0; i < 1000; i++) {
+        buf_repeat(b, "  ", i);
+        buf_puts(b, "* a\n");
+    }
+    corpus_finish(c);
+
+    c = corpus_new("patho-html-openers");
+    b = corpus_add_doc(c);
+    buf_repeat(b, "<>", 50000);
+    corpus_finish(c);
+
+    c = corpus_new("patho-backticks");
+    b = corpus_add_doc(c);
+    for(i = 1; i < 1000; i++) {
+        buf_puts(b, "e");
+        buf_repeat(b, "`", i);
+    }
+    corpus_finish(c);
+
+    c = corpus_new("patho-huge-table");
+    b = corpus_add_doc(c);
+    buf_repeat(b, "th|", 10000);
+    buf_puts(b, "\n");
+    buf_repeat(b, "-|", 10000);
+    buf_puts(b, "\n");
+    buf_repeat(b, "td\n", 10000);
+    corpus_finish(c);
+
+    c = corpus_new("patho-ref-instances");
+    b = corpus_add_doc(c);
+    buf_puts(b, "[x]: ");
+    buf_repeat(b, "x", 50000);
+    buf_repeat(b, "\n[x]", 50000);
+    corpus_finish(c);
+}
+
+
+/*********************
+ ***  Renderers    ***
+ *********************/
+
+typedef int (*RENDER_FN)(const char* input, size_t size, void* userdata);
+
+static void
+count_output(const MD_CHAR* text, MD_SIZE size, void* userdata)
+{
+    (void) text;
+    *(size_t*) userdata += size;
+}
+
+static int
+run_html(const char* in, size_t size, void* ud)
+{
+    return md_html(in, (MD_SIZE) size, count_output, ud, MD_DIALECT_ALL, 0);
+}
+
+static int
+run_ast(const char* in, size_t size, void* ud)
+{
+    return md_ast(in, (MD_SIZE) size, count_output, ud, MD_DIALECT_ALL, 0);
+}
+
+static int
+run_ansi(const char* in, size_t size, void* ud)
+{
+    return md_ansi(in, (MD_SIZE) size, count_output, ud, MD_DIALECT_ALL, 0);
+}
+
+static int
+run_meta(const char* in, size_t size, void* ud)
+{
+    return md_meta(in, (MD_SIZE) size, count_output, ud, MD_DIALECT_ALL, 0);
+}
+
+static int
+run_text(const char* in, size_t size, void* ud)
+{
+    return md_text(in, (MD_SIZE) size, count_output, ud, MD_DIALECT_ALL, 0);
+}
+
+static int
+run_markdown(const char* in, size_t size, void* ud)
+{
+    return md_markdown(in, (MD_SIZE) size, count_output, ud, MD_DIALECT_ALL, 0);
+}
+
+static int
+run_heal(const char* in, size_t size, void* ud)
+{
+    return md_heal(in, (unsigned) size, count_output, ud);
+}
+
+/* md_heal() is meant for streamed chat messages, so it only sees the first
+ * HEAL_MAX_SIZE bytes of each document. */
+#define HEAL_MAX_SIZE   (64 * 1024)
+
+static const struct {
+    const char* name;
+    RENDER_FN fn;
+    size_t max_size;    /* Per-document input limit (0 = whole document). */
+} renderers[] = {
+    { "html", run_html, 0 },
+    { "ast", run_ast, 0 },
+    { "ansi", run_ansi, 0 },
+    { "meta", run_meta, 0 },
+    { "text", run_text, 0 },
+    { "markdown", run_markdown, 0 },
+    { "heal", run_heal, HEAL_MAX_SIZE },
+    { NULL, NULL, 0 }
+};
+
+
+/*********************
+ ***  Measuring    ***
+ *********************/
+
+typedef struct {
+    char name[128];     /* "corpus/renderer" */
+    size_t bytes;
+    double mb_per_s;
+    unsigned long allocs;
+    int runs;
+    int status;         /* Last non-zero renderer return value (or 0). */
+    int corpus;
+    int renderer;
+} RESULT;
+
+static double
+now(void)
+{
+    struct timespec ts;
+#ifdef _WIN32
+    timespec_get(&ts, TIME_UTC);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static size_t
+doc_size(const BUF* doc, size_t max_size)
+{
+    return (max_size > 0  &&  doc->size > max_size) ? max_size : doc->size;
+}
+
+/* Run the renderer over the whole corpus once. Returns the elapsed time. */
+static double
+run_corpus(const CORPUS* c, int r, int* status)
+{
+    size_t out_size = 0;
+    double t0 = now();
+    int i, ret;
+
+    for(i = 0; i < c->n_docs; i++) {
+        ret = renderers[r].fn(c->docs[i].data, doc_size(&c->docs[i], renderers[r].max_size), &out_size);
+        if(ret != 0)
+            *status = ret;
+    }
+    return now() - t0;
+}
+
+static void
+measure(int corpus, int r, double min_time, RESULT* res)
+{
+    const CORPUS* c = &corpora[corpus];
+    double best, total, t;
+    unsigned long allocs0;
+    int i;
+
+    snprintf(res->name, sizeof(res->name), "%s/%s", c->name, renderers[r].name);
+    res->bytes = 0;
+    for(i = 0; i < c->n_docs; i++)
+        res->bytes += doc_size(&c->docs[i], renderers[r].max_size);
+    res->status = 0;
+    res->corpus = corpus;
+    res->renderer = r;
+
+    /* Warm-up run, which also counts the allocations. */
+    allocs0 = bench_n_allocs;
+    total = run_corpus(c, r, &res->status);
+    res->allocs = bench_n_allocs - allocs0;
+    res->runs = 0;
+    best = 1e30;
+
+    /* Keep the fastest of at least 3 further runs. */
+    while(res->runs < 3  ||  total < min_time) {
+        t = run_corpus(c, r, &res->status);
+        if(t < best)
+            best = t;
+        total += t;
+        res->runs++;
+        if(res->runs >= 1000)
+            break;
+    }
+
+    res->mb_per_s = (best > 0) ? (double) res->bytes / 1e6 / best : 0;
+}
+
+
+/************************
+ ***  Baseline JSON   ***
+ ************************/
+
+/* Results are saved one per line, so the baseline can be read back with
+ * sscanf() and diffs of the file stay readable. */
+static int
+save_results(const char* path, const RESULT* results, int n)
+{
+    FILE* f = fopen(path, "w");
+    int i;
+
+    if(f == NULL) {
+        fprintf(stderr, "Cannot open %s.\n", path);
+        return -1;
+    }
+    fprintf(f, "{\n  \"corpus_version\": %d,\n  \"results\": [\n", BENCH_CORPUS_VERSION);
+    for(i = 0; i < n; i++) {
+        fprintf(f, "    {\"name\": \"%s\", \"bytes\": %lu, \"mb_per_s\": %.2f, \"allocs\": %lu, \"status\": %d}%s\n",
+                results[i].name, (unsigned long) results[i].bytes, results[i].mb_per_s,
+                results[i].allocs, results[i].status, (i + 1 < n) ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+    return 0;
+}
+
+typedef struct {
+    char name[128];
+    double mb_per_s;
+    unsigned long allocs;
+    int status;
+} BASELINE;
+
+static BASELINE* baseline = NULL;
+static int n_baseline = 0;
+
+static int
+load_baseline(const char* path)
+{
+    FILE* f = fopen(path, "r");
+    char line[512];
+    int version = -1;
+
+    if(f == NULL)
+        return -1;
+    while(fgets(line, sizeof(line), f) != NULL) {
+        BASELINE b;
+        unsigned long bytes;
+        char* p;
+
+        if((p = strstr(line, "\"corpus_version\":")) != NULL) {
+            version = atoi(p + 17);
+            continue;
+        }
+        if(sscanf(line, " {\"name\": \"%127[^\"]\", \"bytes\": %lu, \"mb_per_s\": %lf, \"allocs\": %lu, \"status\": %d}",
+                  b.name, &bytes, &b.mb_per_s, &b.allocs, &b.status) != 5)
+            continue;
+        baseline = realloc(baseline, (n_baseline + 1) * sizeof(BASELINE));
+        if(baseline == NULL) {
+            fprintf(stderr, "load_baseline: realloc() failed.\n");
+            exit(1);
+        }
+        baseline[n_baseline++] = b;
+    }
+    fclose(f);
+
+    if(version != BENCH_CORPUS_VERSION) {
+        fprintf(stderr, "Baseline %s is for corpus version %d (current is %d); ignoring it.\n",
+                path, version, BENCH_CORPUS_VERSION);
+        n_baseline = 0;
+        return -1;
+    }
+    return 0;
+}
+
+static const BASELINE*
+find_baseline(const char* name)
+{
+    int i;
+    for(i = 0; i < n_baseline; i++) {
+        if(strcmp(baseline[i].name, name) == 0)
+            return &baseline[i];
+    }
+    return NULL;
+}
+
+
+/**********************
+ ***  Reporting     ***
+ **********************/
+
+static double tolerance = 0.2;
+static double alloc_tolerance = 0.02;
+
+typedef enum {
+    VERDICT_OK = 0,
+    VERDICT_NO_BASELINE,
+    VERDICT_FAILED_NEW,     /* Failing without a baseline to compare with. */
+    VERDICT_FAILED,         /* This and all following verdicts fail the run. */
+    VERDICT_STATUS_CHANGED,
+    VERDICT_SLOWER,
+    VERDICT_MORE_ALLOCS
+} VERDICT;
+
+static const char* verdict_names[] = {
+    "", "", "FAILED", "FAILED", "STATUS CHANGED", "SLOWER", "MORE ALLOCS"
+};
+
+static VERDICT
+check_result(const RESULT* res)
+{
+    const BASELINE* base = find_baseline(res->name);
+
+    /* Some pathological inputs exceed renderer limits (e.g. the JSON nesting
+     * depth); that is only a regression if it is new. */
+    if(base == NULL)
+        return (res->status != 0) ? VERDICT_FAILED_NEW : VERDICT_NO_BASELINE;
+    if(res->status != base->status)
+        return (base->status == 0) ? VERDICT_FAILED : VERDICT_STATUS_CHANGED;
+    if(res->mb_per_s < base->mb_per_s * (1.0 - tolerance))
+        return VERDICT_SLOWER;
+    if((double) res->allocs > (double) base->allocs * (1.0 + alloc_tolerance))
+        return VERDICT_MORE_ALLOCS;
+    return VERDICT_OK;
+}
+
+static void
+print_result(const RESULT* res)
+{
+    const BASELINE* base = find_baseline(res->name);
+
+    printf("%-32s %9.1fK %10.2f %12lu ", res->name, (double) res->bytes / 1024,
+           res->mb_per_s, res->allocs);
+    if(base != NULL)
+        printf("%+9.1f%% ", (res->mb_per_s / base->mb_per_s - 1.0) * 100);
+    else
+        printf("%10s ", "-");
+    printf(" %s\n", verdict_names[check_result(res)]);
+    fflush(stdout);
+}
+
+
+/**********************
+ ***  Scaling check ***
+ **********************/
+
+/* Each family generates a document from a repetition count n. The scaling
+ * check renders it at n, 2n, 4n and 8n, with n chosen so that the smallest
+ * document has at least SCALING_MIN_SIZE bytes, and fits the growth of the
+ * render time against the input size on a log-log scale. A slope of 1.0 is
+ * linear; n*log(n) is about 1.1 over this range and quadratic is 2.0. */
+
+#define SCALING_MIN_SIZE    (16 * 1024)
+#define SCALING_STEPS       4
+
+typedef void (*SCALING_GEN)(BUF* b, int n);
+
+static void
+scale_nested_emph(BUF* b, int n)
+{
+    buf_repeat(b, "*a **a ", n);
+    buf_puts(b, "b");
+    buf_repeat(b, " a** a*", n);
+}
+
+static void
+scale_emph_openers(BUF* b, int n)
+{
+    buf_repeat(b, "_a ", n);
+}
+
+static void
+scale_emph_closers(BUF* b, int n)
+{
+    buf_repeat(b, "a_ ", n);
+}
+
+static void
+scale_emph_triple(BUF* b, int n)
+{
+    buf_repeat(b, "a***", n);
+}
+
+static void
+scale_emph_mismatched(BUF* b, int n)
+{
+    buf_repeat(b, "*a_ ", n);
+}
+
+static void
+scale_emph_mod3(BUF* b, int n)
+{
+    buf_puts(b, "a**b");
+    buf_repeat(b, "c* ", n);
+}
+
+static void
+scale_link_openers(BUF* b, int n)
+{
+    buf_repeat(b, "[a", n);
+}
+
+static void
+scale_link_closers(BUF* b, int n)
+{
+    buf_repeat(b, "a]", n);
+}
+
+static void
+scale_link_emph(BUF* b, int n)
+{
+    buf_repeat(b, "[ a_", n);
+}
+
+static void
+scale_nested_brackets(BUF* b, int n)
+{
+    buf_repeat(b, "[", n);
+    buf_puts(b, "a");
+    buf_repeat(b, "]", n);
+}
+
+static void
+scale_nested_quotes(BUF* b, int n)
+{
+    buf_repeat(b, "> ", n);
+    buf_puts(b, "a");
+}
+
+static void
+scale_nested_lists(BUF* b, int n)
+{
+    int i;
+    for(i = 0; i < n; i++) {
+        buf_repeat(b, "  ", i);
+        buf_puts(b, "* a\n");
+    }
+}
+
+/* Many lines at a fixed, deep nesting level (quoted e-mail threads). */
+static void
+scale_quoted_lines(BUF* b, int n)
+{
+    int i;
+    for(i = 0; i < n; i++) {
+        buf_repeat(b, "> ", 16);
+        buf_puts(b, "text *a*\n");
+    }
+}
+
+static void
+scale_list_lines(BUF* b, int n)
+{
+    int i;
+    for(i = 0; i < 16; i++) {
+        buf_repeat(b, "  ", i);
+        buf_puts(b, "* a\n");
+    }
+    for(i = 0; i < n; i++) {
+        buf_repeat(b, "  ", 16);
+        buf_puts(b, "text *a*\n\n");
+    }
+}
+
+static void
+scale_html_openers(BUF* b, int n)
+{
+    buf_repeat(b, "<>", n);
+}
+
+static void
+scale_backticks(BUF* b, int n)
+{
+    int i;
+    for(i = 1; i < n; i++) {
+        buf_puts(b, "e");
+        buf_repeat(b, "`", i);
+    }
+}
+
+static void
+scale_many_refs(BUF* b, int n)
+{
+    int i;
+    for(i = 0; i < n; i++)
+        buf_printf(b, "[r%d]: /u%d\n", i, i);
+    for(i = 0; i < n; i++)
+        buf_printf(b, "[r%d] [x%d] ", i, i);
+}
+
+static void
+scale_ref_instances(BUF* b, int n)
+{
+    buf_puts(b, "[x]: ");
+    buf_repeat(b, "x", 1000);
+    buf_repeat(b, "\n[x]", n);
+}
+
+static void
+scale_table_rows(BUF* b, int n)
+{
+    buf_repeat(b, "th|", 100);
+    buf_puts(b, "\n");
+    buf_repeat(b, "-|", 100);
+    buf_puts(b, "\n");
+    buf_repeat(b, "td\n", n);
+}
+
+static void
+scale_entities(BUF* b, int n)
+{
+    buf_repeat(b, "&amp; &#123; &#x1F600; &bogus; &eacute;\n", n);
+}
+
+static void
+scale_cjk(BUF* b, int n)
+{
+    buf_repeat(b, "日本語の**強調**テキスト、*斜体*と`コード`。\n", n);
+}
+
+static void
+scale_autolinks(BUF* b, int n)
+{
+    buf_repeat(b, "www.example.com/a_b http://x.org/p?q=1 me@example.com ", n);
+}
+
+static void
+scale_components_inline(BUF* b, int n)
+{
+    buf_repeat(b, ":badge[New]{color=\"blue\" .c #d} ", n);
+}
+
+static void
+scale_components_open_content(BUF* b, int n)
+{
+    buf_repeat(b, ":a[x ", n);
+}
+
+static void
+scale_components_open_props(BUF* b, int n)
+{
+    buf_repeat(b, ":a{k=\"v ", n);
+}
+
+static void
+scale_components_block(BUF* b, int n)
+{
+    buf_repeat(b, "::alert{type=\"info\"}\ntext\n::\n\n", n);
+}
+
+static void
+scale_components_unclosed(BUF* b, int n)
+{
+    buf_puts(b, "::a{k=v}\n");
+    buf_repeat(b, "text *a* :b[c]\n", n);
+}
+
+static void
+scale_components_nested(BUF* b, int n)
+{
+    int i;
+    for(i = 0; i < n; i++) {
+        buf_repeat(b, ":", i + 2);
+        buf_puts(b, "c\n");
+    }
+    for(i = n - 1; i >= 0; i--) {
+        buf_repeat(b, ":", i + 2);
+        buf_puts(b, "\n");
+    }
+}
+
+/* Every line opens one more block component, so each is nested n deep. */
+static void
+scale_components_nested_open(BUF* b, int n)
+{
+    buf_repeat(b, "::a\n", n);
+}
+
+static void
+scale_attributes(BUF* b, int n)
+{
+    buf_repeat(b, "**b**{.c #d k=v} [l](u){.e} ", n);
+}
+
+static void
+scale_attributes_open(BUF* b, int n)
+{
+    buf_repeat(b, "*a*{.c ", n);
+}
+
+static void
+scale_wikilinks(BUF* b, int n)
+{
+    buf_repeat(b, "[[Page|label]] ", n);
+}
+
+static void
+scale_wikilinks_open(BUF* b, int n)
+{
+    buf_repeat(b, "[[a ", n);
+}
+
+static void
+scale_wikilinks_nested(BUF* b, int n)
+{
+    buf_repeat(b, "[[", n);
+    buf_puts(b, "a");
+    buf_repeat(b, "]]", n);
+}
+
+static void
+scale_alerts(BUF* b, int n)
+{
+    buf_repeat(b, "> [!NOTE]\n> text\n\n", n);
+}
+
+static void
+scale_alerts_long(BUF* b, int n)
+{
+    buf_puts(b, "> [!WARNING]\n");
+    buf_repeat(b, "> line *a*\n", n);
+}
+
+static void
+scale_math(BUF* b, int n)
+{
+    buf_repeat(b, "$x^2$ and $$y$$ ", n);
+}
+
+static void
+scale_math_open(BUF* b, int n)
+{
+    buf_repeat(b, "$a ", n);
+}
+
+static void
+scale_math_open_display(BUF* b, int n)
+{
+    buf_repeat(b, "$$a ", n);
+}
+
+static void
+scale_math_block(BUF* b, int n)
+{
+    buf_repeat(b, "$$\nx\n$$\n", n);
+}
+
+static const struct {
+    const char* name;
+    SCALING_GEN gen;
+} scaling_families[] = {
+    { "patho-nested-emph", scale_nested_emph },
+    { "patho-emph-openers", scale_emph_openers },
+    { "patho-emph-closers", scale_emph_closers },
+    { "patho-emph-triple", scale_emph_triple },
+    { "patho-emph-mismatched", scale_emph_mismatched },
+    { "patho-emph-mod3", scale_emph_mod3 },
+    { "patho-link-openers", scale_link_openers },
+    { "patho-link-closers", scale_link_closers },
+    { "patho-link-emph", scale_link_emph },
+    { "patho-nested-brackets", scale_nested_brackets },
+    { "patho-nested-quotes", scale_nested_quotes },
+    { "patho-nested-lists", scale_nested_lists },
+    { "patho-quoted-lines", scale_quoted_lines },
+    { "patho-list-lines", scale_list_lines },
+    { "patho-html-openers", scale_html_openers },
+    { "patho-backticks", scale_backticks },
+    { "patho-many-refs", scale_many_refs },
+    { "patho-ref-instances", scale_ref_instances },
+    { "patho-table-rows", scale_table_rows },
+    { "entities", scale_entities },
+    { "cjk", scale_cjk },
+    { "autolinks", scale_autolinks },
+    { "components-inline", scale_components_inline },
+    { "components-open-content", scale_components_open_content },
+    { "components-open-props", scale_components_open_props },
+    { "components-block", scale_components_block },
+    { "components-unclosed", scale_components_unclosed },
+    { "components-nested", scale_components_nested },
+    { "components-nested-open", scale_components_nested_open },
+    { "attributes", scale_attributes },
+    { "attributes-open", scale_attributes_open },
+    { "wikilinks", scale_wikilinks },
+    { "wikilinks-open", scale_wikilinks_open },
+    { "wikilinks-nested", scale_wikilinks_nested },
+    { "alerts", scale_alerts },
+    { "alerts-long", scale_alerts_long },
+    { "math", scale_math },
+    { "math-open", scale_math_open },
+    { "math-open-display", scale_math_open_display },
+    { "math-block", scale_math_block },
+    { NULL, NULL }
+};
+
+/* Fastest time of at least 3 renderings of the document (and at least
+ * min_time in total). */
+static double
+time_doc(int r, const BUF* doc, double min_time, int* status)
+{
+    size_t out_size = 0;
+    double best = 1e30, total = 0, t0, t;
+    int runs, ret;
+
+    for(runs = 0; runs < 3  ||  total < min_time; runs++) {
+        t0 = now();
+        ret = renderers[r].fn(doc->data, doc->size, &out_size);
+        t = now() - t0;
+        if(ret != 0)
+            *status = ret;
+        if(t < best)
+            best = t;
+        total += t;
+        if(runs >= 1000)
+            break;
+    }
+    return best;
+}
+
+/* Least-squares slope of log(time) over log(size). */
+static double
+fit_slope(const BUF* docs, const double* times, int n)
+{
+    double sx = 0, sy = 0, sxx = 0, sxy = 0, x, y;
+    int i;
+
+    for(i = 0; i < n; i++) {
+        x = log((double) docs[i].size);
+        y = log(times[i] > 1e-9 ? times[i] : 1e-9);
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+    }
+    return (n * sxy - sx * sy) / (n * sxx - sx * sx);
+}
+
+static double
+measure_scaling(int r, const BUF* docs, double min_time, int* status)
+{
+    double times[SCALING_STEPS];
+    int i;
+
+    *status = 0;
+    for(i = 0; i < SCALING_STEPS; i++)
+        times[i] = time_doc(r, &docs[i], min_time, status);
+    return fit_slope(docs, times, SCALING_STEPS);
+}
+
+/* Render every scaling family with every renderer. Returns the number of
+ * renderings growing faster than max_slope. */
+static int
+run_scaling(const char* filter, double min_time, double max_slope)
+{
+    BUF docs[SCALING_STEPS];
+    int n_superlinear = 0;
+    int f, r, i, n, status, retry;
+    double slope, again;
+
+    printf("%-40s %10s %10s %8s  %s\n", "family", "size(n)", "size(8n)", "slope", "");
+    for(f = 0; scaling_families[f].name != NULL; f++) {
+        char name[128];
+
+        /* Only generate the documents if some renderer is selected. */
+        for(r = 0; renderers[r].name != NULL; r++) {
+            snprintf(name, sizeof(name), "%s/%s", scaling_families[f].name, renderers[r].name);
+            if(filter == NULL  ||  strstr(name, filter) != NULL)
+                break;
+        }
+        if(renderers[r].name == NULL)
+            continue;
+
+        memset(docs, 0, sizeof(docs));
+        for(n = 16; ; n *= 2) {
+            docs[0].size = 0;
+            scaling_families[f].gen(&docs[0], n);
+            if(docs[0].size >= SCALING_MIN_SIZE)
+                break;
+        }
+        for(i = 1; i < SCALING_STEPS; i++)
+            scaling_families[f].gen(&docs[i], n << i);
+
+        for(r = 0; renderers[r].name != NULL; r++) {
+            snprintf(name, sizeof(name), "%s/%s", scaling_families[f].name, renderers[r].name);
+            if(filter != NULL  &&  strstr(name, filter) == NULL)
+                continue;
+
+            slope = measure_scaling(r, docs, min_time, &status);
+            /* Re-measure before reporting, as with the throughput results. */
+            for(retry = 0; retry < 2  &&  status == 0  &&  slope > max_slope; retry++) {
+                again = measure_scaling(r, docs, min_time, &status);
+                if(again < slope)
+                    slope = again;
+            }
+
+            printf("%-40s %9.1fK %9.1fK %8.2f  ", name, (double) docs[0].size / 1024,
+                   (double) docs[SCALING_STEPS - 1].size / 1024, slope);
+            /* Renderer limits (e.g. the JSON nesting depth) cut the work short,
+             * so the slope means nothing then. */
+            if(status != 0) {
+                printf("FAILED (%d), ignored\n", status);
+            } else if(slope > max_slope) {
+                printf("SUPERLINEAR\n");
+                n_superlinear++;
+            } else {
+                printf("\n");
+            }
+            fflush(stdout);
+        }
+
+        for(i = 0; i < SCALING_STEPS; i++)
+            free(docs[i].data);
+    }
+    return n_superlinear;
+}
+
+
+/**********************
+ ***  Main program  ***
+ **********************/
+
+static void
+usage(void)
+{
+    printf(
+        "Usage: md4x-bench [OPTION]...\n"
+        "Benchmark the MD4X renderers on the built-in corpus.\n"
+        "\n"
+        "  --root=DIR             Repository root (default: current directory)\n"
+        "  --baseline=FILE        Baseline to compare with (default: test/bench/baseline.json)\n"
+        "  --save=FILE            Write the results as a new baseline\n"
+        "  --tolerance=X          Allowed throughput loss ratio (default: 0.2)\n"
+        "  --alloc-tolerance=X    Allowed allocation count growth ratio (default: 0.02)\n"
+        "  --min-time=SEC         Minimum measuring time per result (default: 0.2)\n"
+        "  --filter=TEXT          Only run results whose name contains TEXT\n"
+        "  --scaling              Check that render time grows at most linearithmically\n"
+        "                         with the input size instead of comparing throughput\n"
+        "  --max-slope=X          Largest allowed log-log growth rate (default: 1.4)\n"
+        "  -h, --help             Display this help and exit\n"
+    );
+}
+
+static const char*
+arg_value(const char* arg, const char* name)
+{
+    size_t len = strlen(name);
+    if(strncmp(arg, name, len) == 0  &&  arg[len] == '=')
+        return arg + len + 1;
+    return NULL;
+}
+
+int
+main(int argc, char** argv)
+{
+    const char* root = ".";
+    const char* baseline_path = NULL;
+    const char* save_path = NULL;
+    const char* filter = NULL;
+    double min_time = 0.2;
+    double max_slope = 1.4;
+    int scaling = 0;
+    char default_baseline[1024];
+    RESULT* results;
+    int n_results = 0;
+    int n_regressions = 0;
+    int i, r, retry;
+    const char* v;
+
+    for(i = 1; i < argc; i++) {
+        if((v = arg_value(argv[i], "--root")) != NULL)
+            root = v;
+        else if((v = arg_value(argv[i], "--baseline")) != NULL)
+            baseline_path = v;
+        else if((v = arg_value(argv[i], "--save")) != NULL)
+            save_path = v;
+        else if((v = arg_value(argv[i], "--tolerance")) != NULL)
+            tolerance = atof(v);
+        else if((v = arg_value(argv[i], "--alloc-tolerance")) != NULL)
+            alloc_tolerance = atof(v);
+        else if((v = arg_value(argv[i], "--min-time")) != NULL)
+            min_time = atof(v);
+        else if((v = arg_value(argv[i], "--filter")) != NULL)
+            filter = v;
+        else if((v = arg_value(argv[i], "--max-slope")) != NULL)
+            max_slope = atof(v);
+        else if(strcmp(argv[i], "--scaling") == 0)
+            scaling = 1;
+        else if(strcmp(argv[i], "-h") == 0  ||  strcmp(argv[i], "--help") == 0) {
+            usage();
+            return 0;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            usage();
+            return 2;
+        }
+    }
+
+    if(scaling) {
+        /* Each family is timed at four sizes, so spend less on each. */
+        n_regressions = run_scaling(filter, min_time / 4, max_slope);
+        if(n_regressions > 0) {
+            fprintf(stderr, "\n%d rendering(s) grow faster than the allowed slope %.2f.\n",
+                    n_regressions, max_slope);
+            return 1;
+        }
+        return 0;
+    }
+
+    if(baseline_path == NULL) {
+        snprintf(default_baseline, sizeof(default_baseline), "%s/test/bench/baseline.json", root);
+        baseline_path = default_baseline;
+    }
+    if(load_baseline(baseline_path) != 0  &&  n_baseline == 0)
+        fprintf(stderr, "No baseline loaded from %s; only reporting.\n", baseline_path);
+
+    gen_spec(root);
+    gen_docs();
+    gen_deep_lists();
+    gen_huge_table();
+    gen_prose();
+    gen_entity_dense();
+    gen_cjk();
+    gen_code_heavy();
+    gen_html_heavy();
+    gen_link_ref_heavy();
+    gen_pathological();
+
+    results = calloc(n_corpora * (sizeof(renderers) / sizeof(renderers[0])), sizeof(RESULT));
+    if(results == NULL) {
+        fprintf(stderr, "calloc() failed.\n");
+        return 1;
+    }
+
+    printf("%-32s %10s %10s %12s %10s  %s\n", "benchmark", "size", "MB/s", "allocs/run", "baseline", "");
+    for(i = 0; i < n_corpora; i++) {
+        for(r = 0; renderers[r].name != NULL; r++) {
+            RESULT* res = &results[n_results];
+            char name[128];
+
+            snprintf(name, sizeof(name), "%s/%s", corpora[i].name, renderers[r].name);
+            if(filter != NULL  &&  strstr(name, filter) == NULL)
+                continue;
+
+            measure(i, r, min_time, res);
+            if(save_path != NULL) {
+                /* Save the median of three measurements, so that a lucky
+                 * run does not end up in the baseline. */
+                RESULT again[2];
+                double lo, hi;
+                measure(i, r, min_time, &again[0]);
+                measure(i, r, min_time, &again[1]);
+                lo = (again[0].mb_per_s < again[1].mb_per_s) ? again[0].mb_per_s : again[1].mb_per_s;
+                hi = (again[0].mb_per_s < again[1].mb_per_s) ? again[1].mb_per_s : again[0].mb_per_s;
+                if(res->mb_per_s < lo)
+                    res->mb_per_s = lo;
+                else if(res->mb_per_s > hi)
+                    res->mb_per_s = hi;
+            }
+            print_result(res);
+            n_results++;
+        }
+    }
+
+    /* Re-measure apparent slowdowns at the end of the run before reporting
+     * them: a result is easily disturbed by a burst of other system load. */
+    for(retry = 0; retry < 2; retry++) {
+        int n_slower = 0;
+
+        for(i = 0; i < n_results; i++) {
+            if(check_result(&results[i]) == VERDICT_SLOWER)
+                n_slower++;
+        }
+        if(n_slower == 0)
+            break;
+
+        printf("\nRe-checking %d slower result(s):\n", n_slower);
+        for(i = 0; i < n_results; i++) {
+            RESULT again;
+
+            if(check_result(&results[i]) != VERDICT_SLOWER)
+                continue;
+            measure(results[i].corpus, results[i].renderer, min_time, &again);
+            if(again.mb_per_s > results[i].mb_per_s)
+                results[i].mb_per_s = again.mb_per_s;
+            print_result(&results[i]);
+        }
+    }
+
+    for(i = 0; i < n_results; i++) {
+        if(check_result(&results[i]) >= VERDICT_FAILED)
+            n_regressions++;
+    }
+
+    if(save_path != NULL  &&  save_results(save_path, results, n_results) != 0)
+        return 1;
+
+    if(n_regressions > 0) {
+        fprintf(stderr, "\n%d result(s) regressed against %s.\n", n_regressions, baseline_path);
+        return 1;
+    }
+    return 0;
+}
@@ -13,6 +13,7 @@
 #   ./fuzz-mdhtml  test/fuzzers/seed-corpus/
 #   ./fuzz-mdast   test/fuzzers/seed-corpus/
 #   ./fuzz-mdheal  test/fuzzers/seed-corpus/
+#   ./fuzz-mdperf  -use_value_profile=1 test/fuzzers/perf-corpus/ test/fuzzers/seed-corpus/
 
 set -e
 
@@ -115,6 +116,21 @@ build_heal() {
         -o "$OUT_DIR/fuzz-mdheal"
 }
 
+build_perf() {
+    echo "Building fuzz-mdperf..."
+    $CC $CFLAGS \
+        "$FUZZ_DIR/fuzz-mdperf.c" \
+        "$SRC/md4x.c" "$SRC/entity.c" \
+        "$RENDERERS/md4x-multi.c" \
+        "$RENDERERS/md4x-html.c" \
+        "$RENDERERS/md4x-ast.c" \
+        "$RENDERERS/md4x-meta.c" \
+        "$RENDERERS/md4x-text.c" \
+        "$RENDERERS/md4x-heal.c" \
+        -lyaml \
+        -o "$OUT_DIR/fuzz-mdperf"
+}
+
 if [ $# -eq 0 ]; then
     build_html
     build_ast
@@ -123,6 +139,7 @@ if [ $# -eq 0 ]; then
     build_meta
     build_markdown
     build_heal
+    build_perf
     echo "All fuzzers built in $OUT_DIR/"
 else
     for target in "$@"; do
@@ -134,6 +151,7 @@ else
             fuzz-mdmeta|meta)  build_meta ;;
             fuzz-mdmarkdown|markdown)  build_markdown ;;
             fuzz-mdheal|heal)  build_heal ;;
+            fuzz-mdperf|perf)  build_perf ;;
             *) echo "Unknown target: $target" >&2; exit 1 ;;
         esac
     done
@@ -0,0 +1,242 @@
+/*
+ * MD4X: Markdown parser for C
+ * (http://github.com/unjs/md4x)
+ *
+ * Copyright (c) 2026 Pooya Parsa <pooya@pi0.io>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Performance-guided fuzzer: hunts for inputs that make the parser do a lot
+ * of work per input byte (super-linear behavior), not only for crashes.
+ *
+ * Every input is parsed and rendered to HTML with md_render_multi(), which
+ * fills MD_PARSE_STATS. The cost per byte of the counters (marks, rollbacks,
+ * lines, blocks, containers) and of the internal buffer sizes is reported to
+ * libFuzzer as extra coverage counters, one per log-scaled bucket, so inputs
+ * reaching a new, higher cost bucket are kept in the corpus and mutated
+ * further. The custom mutator additionally repeats random slices of the
+ * input, since blowups usually need many repetitions of a small pattern.
+ *
+ * Environment variables:
+ *   MD4X_PERF_CORPUS=DIR    Save each input that sets a new worst cost per
+ *                           byte (or time per byte) into DIR.
+ *   MD4X_PERF_MAX_COST=N    Abort (report a crash) if the work counters
+ *                           exceed N per input byte.
+ *   MD4X_PERF_MAX_NS=N      Abort if parsing and rendering take more than
+ *                           N nanoseconds per input byte (best of 3 runs).
+ *   MD4X_PERF_VERBOSE=1     Print the cost of every input.
+ *
+ * Run with -use_value_profile=1 (see run.sh). To check a regression corpus:
+ *   MD4X_PERF_MAX_NS=2000 ./fuzz-mdperf -runs=0 test/fuzzers/perf-corpus
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "md4x.h"
+#include "md4x-multi.h"
+#include "fuzz-common.h"
+
+
+/* Time per byte of smaller inputs is dominated by the constant overhead. */
+#define PERF_MIN_TIMED_SIZE     256
+
+/* libFuzzer treats the counters in this section as additional coverage
+ * (Linux only; elsewhere they are ignored and only the value profile
+ * guides the fuzzer). */
+#define PERF_FEATURES           6
+#define PERF_BUCKETS            32
+
+#ifdef __linux__
+__attribute__((section("__libfuzzer_extra_counters")))
+#endif
+static uint8_t perf_counters[PERF_FEATURES][PERF_BUCKETS];
+
+size_t LLVMFuzzerMutate(uint8_t* data, size_t size, size_t max_size);
+
+static double worst_cost = 0;   /* Highest work counters per byte so far. */
+static double worst_ns = 0;     /* Highest nanoseconds per byte so far. */
+
+
+static void
+process_output(const MD_CHAR* text, MD_SIZE size, void* userdata)
+{
+   return;
+}
+
+static double
+env_double(const char* name)
+{
+    const char* v = getenv(name);
+    return (v != NULL) ? atof(v) : 0;
+}
+
+/* Bucket of value/size on a log2 scale with 2 steps per doubling,
+ * from 1/16 per byte up. */
+static int
+cost_bucket(unsigned long long value, size_t size)
+{
+    unsigned long long ratio = value * 16 / size;
+    int msb = 0;
+    int bucket;
+
+    if(ratio == 0)
+        return 0;
+    while((ratio >> msb) > 1)
+        msb++;
+    bucket = 1 + msb * 2 + (msb >= 1 ? (int) ((ratio >> (msb - 1)) & 1) : 0);
+    return (bucket < PERF_BUCKETS) ? bucket : PERF_BUCKETS - 1;
+}
+
+static void
+save_input(const uint8_t* data, size_t size, const char* why, double value)
+{
+    const char* dir = getenv("MD4X_PERF_CORPUS");
+    uint32_t hash = 2166136261u;
+    char path[1024];
+    FILE* f;
+    size_t i;
+
+    if(dir == NULL)
+        return;
+    for(i = 0; i < size; i++)
+        hash = (hash ^ data[i]) * 16777619u;
+    snprintf(path, sizeof(path), "%s/perf-%08x.md", dir, (unsigned) hash);
+    f = fopen(path, "wb");
+    if(f == NULL)
+        return;
+    fwrite(data, 1, size, f);
+    fclose(f);
+    fprintf(stderr, "md4x-perf: new worst %s %.2f per byte (%u bytes): %s\n",
+            why, value, (unsigned) size, path);
+}
+
+static unsigned long long
+parse_ns(const uint8_t* data, size_t size, MD_PARSE_STATS* stats)
+{
+    MD_RENDER_TARGET target;
+
+    memset(&target, 0, sizeof(target));
+    target.format = MD_RENDER_HTML;
+    target.process_output = process_output;
+    memset(stats, 0, sizeof(MD_PARSE_STATS));
+    md_render_multi((const MD_CHAR*) data, (MD_SIZE) size, &target, 1,
+                    MD_DIALECT_ALL, 0, NULL, stats);
+    return stats->block_ns + stats->ref_def_ns + stats->mark_ns +
+           stats->resolve_ns + stats->emit_ns;
+}
+
+int
+LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    MD_PARSE_STATS stats;
+    unsigned long long work, ns, again;
+    double cost, ns_per_byte, max;
+    int i;
+
+    if(size == 0 || !is_valid_utf8(data, size))
+        return -1;
+
+    ns = parse_ns(data, size, &stats);
+
+    work = (unsigned long long) stats.n_marks + stats.n_rollbacks + stats.n_lines +
+           stats.n_blocks + stats.n_containers;
+    perf_counters[0][cost_bucket(work, size)] = 1;
+    perf_counters[1][cost_bucket(stats.n_rollbacks, size)] = 1;
+    perf_counters[2][cost_bucket(stats.n_containers, size)] = 1;
+    perf_counters[3][cost_bucket(stats.peak_mark_bytes, size)] = 1;
+    perf_counters[4][cost_bucket(stats.peak_block_bytes + stats.peak_container_bytes, size)] = 1;
+    perf_counters[5][cost_bucket(stats.peak_buffer_bytes, size)] = 1;
+
+    cost = (double) work / size;
+    if(cost > worst_cost) {
+        worst_cost = cost;
+        save_input(data, size, "cost", cost);
+    }
+    max = env_double("MD4X_PERF_MAX_COST");
+    if(max > 0  &&  cost > max) {
+        fprintf(stderr, "md4x-perf: %.2f work units per byte exceed MD4X_PERF_MAX_COST=%g\n", cost, max);
+        abort();
+    }
+
+    if(size >= PERF_MIN_TIMED_SIZE) {
+        /* Confirm a suspicious time with two more runs, keeping the best,
+         * so that a burst of system load is not mistaken for a blowup. */
+        ns_per_byte = (double) ns / size;
+        max = env_double("MD4X_PERF_MAX_NS");
+        if(ns_per_byte > worst_ns  ||  (max > 0  &&  ns_per_byte > max)) {
+            for(i = 0; i < 2; i++) {
+                again = parse_ns(data, size, &stats);
+                if(again < ns)
+                    ns = again;
+            }
+            ns_per_byte = (double) ns / size;
+        }
+        if(ns_per_byte > worst_ns) {
+            worst_ns = ns_per_byte;
+            save_input(data, size, "ns", ns_per_byte);
+        }
+        if(max > 0  &&  ns_per_byte > max) {
+            fprintf(stderr, "md4x-perf: %.0f ns per byte exceed MD4X_PERF_MAX_NS=%g\n", ns_per_byte, max);
+            abort();
+        }
+    } else {
+        ns_per_byte = 0;
+    }
+
+    if(getenv("MD4X_PERF_VERBOSE") != NULL) {
+        fprintf(stderr, "md4x-perf: %u bytes, %.2f work units/byte, %.0f ns/byte, "
+                "%u marks, %u rollbacks, %u containers\n", (unsigned) size, cost,
+                ns_per_byte, stats.n_marks, stats.n_rollbacks, stats.n_containers);
+    }
+    return 0;
+}
+
+/* Most of the time, mutate as libFuzzer would. Otherwise repeat a random
+ * slice of up to 16 bytes in place, up to max_size. */
+size_t
+LLVMFuzzerCustomMutator(uint8_t* data, size_t size, size_t max_size, unsigned int seed)
+{
+    unsigned r = seed;
+    size_t beg, len, count, tail, i;
+
+    if(size == 0  ||  size >= max_size  ||  (r % 4) != 0)
+        return LLVMFuzzerMutate(data, size, max_size);
+
+    r = r * 1103515245u + 12345u;
+    beg = (r >> 8) % size;
+    r = r * 1103515245u + 12345u;
+    len = 1 + (r >> 8) % (size - beg < 16 ? size - beg : 16);
+    r = r * 1103515245u + 12345u;
+    count = 1 + (r >> 8) % ((max_size - size) / len + 1);
+    if(count > (max_size - size) / len)
+        count = (max_size - size) / len;
+    if(count == 0)
+        return LLVMFuzzerMutate(data, size, max_size);
+
+    /* Make room after the slice and fill it with copies. */
+    tail = size - (beg + len);
+    memmove(data + beg + len * (count + 1), data + beg + len, tail);
+    for(i = 1; i <= count; i++)
+        memcpy(data + beg + len * i, data + beg, len);
+    return size + len * count;
+}
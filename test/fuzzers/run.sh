@@ -6,9 +6,14 @@
 #   ./test/fuzzers/run.sh ast --timeout 300           # run for 300 seconds
 #   ./test/fuzzers/run.sh heal --cores 4              # run heal fuzzer with 4 cores
 #   ./test/fuzzers/run.sh html --cores 4 --timeout 0  # run forever with 4 cores
+#   ./test/fuzzers/run.sh perf                        # hunt for super-linear inputs
 #
 # Corpus is stored in test/fuzzers/corpus/<name>/ (gitignored).
 # Seed corpus from test/fuzzers/seed-corpus/ is used as read-only seed.
+#
+# The perf fuzzer also reads test/fuzzers/perf-corpus/ and saves new worst
+# cases (highest parse cost per byte) there; commit the ones worth keeping
+# as regression inputs.
 
 set -e
 
@@ -39,15 +44,25 @@ while [ $# -gt 0 ]; do
 done
 
 if [ -z "$TARGET" ]; then
-    echo "Usage: $0 <html|ast|ansi|text|meta|markdown|heal> [--timeout SECONDS] [--cores N]" >&2
+    echo "Usage: $0 <html|ast|ansi|text|meta|markdown|heal|perf> [--timeout SECONDS] [--cores N]" >&2
     exit 1
 fi
 
 case "$TARGET" in
-    html|ast|ansi|text|meta|markdown|heal) ;;
-    *) echo "Unknown target: $TARGET (expected: html, ast, ansi, text, meta, markdown, heal)" >&2; exit 1 ;;
+    html|ast|ansi|text|meta|markdown|heal|perf) ;;
+    *) echo "Unknown target: $TARGET (expected: html, ast, ansi, text, meta, markdown, heal, perf)" >&2; exit 1 ;;
 esac
 
+# The perf fuzzer is guided by the parse cost (see fuzz-mdperf.c).
+EXTRA_DIRS=""
+EXTRA_FLAGS=""
+if [ "$TARGET" = "perf" ]; then
+    PERF_DIR="$ROOT/test/fuzzers/perf-corpus"
+    export MD4X_PERF_CORPUS="$PERF_DIR"
+    EXTRA_DIRS="$PERF_DIR"
+    EXTRA_FLAGS="-use_value_profile=1"
+fi
+
 BINARY="$FUZZ_OUT/fuzz-md$TARGET"
 
 # Build the fuzzer
@@ -63,7 +78,7 @@ trap 'echo ""; echo "Interrupted."; exit 0' INT
 
 echo "Running fuzz-md$TARGET (-fork=$CORES), artifacts in $ARTIFACT_DIR..."
 while true; do
-    "$BINARY" "$CORPUS_DIR/$TARGET" "$SEED_DIR" \
+    "$BINARY" "$CORPUS_DIR/$TARGET" "$SEED_DIR" $EXTRA_DIRS $EXTRA_FLAGS \
         -max_total_time="$MAX_TIME" \
         -fork="$CORES" \
         -artifact_prefix="$ARTIFACT_DIR/" || true
@@ -26,6 +26,27 @@ pathological = {
     "U+FEFF (Unicode BOM)":
             ("\ufefffoo",
             re.compile("<p>foo</p>")),
+    # Line breaks, controls and invalid UTF-8 (written as a surrogate escape)
+    # inside YAML comments, which the flat frontmatter scanner must leave to
+    # libyaml.
+    "NEL in a frontmatter comment":
+            ("::card\n\n---\n# c\u0085x: 1\na: 2\n---\n\nC\n::",
+            re.compile('<card x="1" a="2">')),
+    "LS in a frontmatter comment":
+            ("::card\n\n---\na: 1\n# c\u2028y: 2\n---\n\nC\n::",
+            re.compile('<card a="1" y="2">')),
+    "PS in a frontmatter comment":
+            ("::card\n\n---\na: 1\n# c\u2029y: 2\n---\n\nC\n::",
+            re.compile('<card a="1" y="2">')),
+    "CR in a frontmatter comment":
+            ("::card\n\n---\na: 1\n# c\ry: 2\n---\n\nC\n::",
+            re.compile('<card a="1" y="2">')),
+    "U+0001 in a frontmatter comment":
+            ("::card\n\n---\na: 1\n# c\u0001\nb: 2\n---\n\nC\n::",
+            re.compile('<card>\n')),
+    "invalid UTF-8 in a frontmatter comment":
+            ("::card\n\n---\na: 1\n# c\udcff\nb: 2\n---\n\nC\n::",
+            re.compile('<card>\n')),
     "nested strong emph":
             (("*a **a " * 65000) + "b" + (" a** a*" * 65000),
             re.compile("(<em>a <strong>a ){65000}b( a</strong> a</em>){65000}")),
@@ -104,6 +125,12 @@ pathological = {
     "many broken links":
             (("]([\n" * 50000),
             re.compile(r"<p>(\]\(\[\r?\n){49999}\]\(\[</p>")),
+    "many unclosed block components":
+            (("::a\n" * 50000),
+            re.compile("(<a>\r?\n){50000}(</a>\r?\n){50000}")),
+    "deeply quoted lines":
+            (("> " * 100 + "a\n") * 5000,
+            re.compile("(<blockquote>\r?\n){100}<p>a\r?\n(a\r?\n){4998}a</p>")),
     "many link ref. def. instantiations":
             (("[x]: " + "x" * 50000 + "\n[x]" * 50000),
             re.compile(""))
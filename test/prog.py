@@ -7,7 +7,7 @@ import os
 
 def pipe_through_prog(argv, text):
     p1 = Popen(argv, stdout=PIPE, stdin=PIPE, stderr=PIPE)
-    [result, err] = p1.communicate(input=text.encode('utf-8'))
+    [result, err] = p1.communicate(input=text.encode('utf-8', 'surrogateescape'))
     return [p1.returncode, result.decode('utf-8'), err]
 
 class Prog:
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+# Renders huge documents through the CLI, which maps the input and streams
+# the output. Needs a build with 64-bit offsets:
+#
+#   zig build -Dwide-offsets=true
+#   python3 wide-offsets-test.py -p ../zig-out/bin/md4x
+#
+# "4 GiB + 64 KiB input" is a sparse file: a heading and a code fence, then a
+# hole of NUL characters (each rendered as U+FFFD) up to past 4 GiB, then a
+# paragraph whose offsets only fit into a 64-bit MD_OFFSET.
+#
+# "100M code lines" is a 200 MB code block whose line records take more than
+# 2 GiB, which overflowed the int sizes of the block buffer.
+#
+# "4 GiB + 64 KiB input, meta" renders the sparse document again with the code
+# block and top-level block metadata appended, whose offsets pass 4 GiB too.
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+from timeit import default_timer as timer
+
+parser = argparse.ArgumentParser(description='Run the huge input tests.')
+parser.add_argument('-p', '--program', dest='program', nargs='?', default='md4x',
+        help='program to test')
+args = parser.parse_args(sys.argv[1:])
+
+
+def write_sparse(f):
+    head = b"# Head\n\n```\n"
+    tail = b"\n```\n\nTail *emph* [link](/url)\n"
+    size = (4 << 30) + (64 << 10)
+    f.write(head)
+    f.truncate(size - len(tail))
+    f.seek(0, os.SEEK_END)
+    f.write(tail)
+    n_nul = size - len(head) - len(tail)
+    return (b"<h1>Head</h1>\n<pre><code>",
+            b"\n</code></pre>\n<p>Tail <em>emph</em> <a href=\"/url\">link</a></p>\n",
+            3 * n_nul)
+
+
+def write_sparse_meta(f):
+    (head, tail, middle_size) = write_sparse(f)
+    size = len(head) + middle_size + len(tail)
+    code_end = len(head) + middle_size + 1
+    block_ends = [len(b"<h1>Head</h1>\n"), code_end + len(b"</code></pre>\n"), size]
+    tail += b'\0[{"s":%d,"e":%d}]' % (len(b"<h1>Head</h1>\n<pre><code>"), code_end)
+    tail += b"\0[" + b",".join(b"%d" % end for end in block_ends) + b"]"
+    return (head, tail, middle_size)
+
+
+def write_many_lines(f):
+    n_lines = 100 * 1000 * 1000
+    chunk = b"a\n" * (1000 * 1000)
+    f.write(b"```\n")
+    for i in range(n_lines // (1000 * 1000)):
+        f.write(chunk)
+    f.write(b"```\n")
+    return (b"<pre><code>a\n", b"a\n</code></pre>\n", 2 * (n_lines - 2))
+
+
+# Each case has extra program options and a function which writes its input
+# and returns the expected output head and tail, and the size of the output
+# between them.
+cases = {
+    "4 GiB + 64 KiB input": ([], write_sparse),
+    "4 GiB + 64 KiB input, meta": (["--html-code-meta", "--html-block-meta"], write_sparse_meta),
+    "100M code lines": ([], write_many_lines),
+}
+
+passed = 0
+failed = 0
+errored = 0
+
+for description in cases:
+    with tempfile.NamedTemporaryFile(suffix='.md') as f:
+        (options, write) = cases[description]
+        (expected_head, expected_tail, middle_size) = write(f)
+        f.flush()
+        expected_size = len(expected_head) + middle_size + len(expected_tail)
+
+        start = timer()
+        p = subprocess.Popen(args.program.split() + options + [f.name],
+                stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        out_head = p.stdout.read(len(expected_head))
+        out_size = len(out_head)
+        out_tail = b""
+        while True:
+            chunk = p.stdout.read(1 << 20)
+            if not chunk:
+                break
+            out_size += len(chunk)
+            out_tail = (out_tail + chunk)[-len(expected_tail):]
+        err = p.stderr.read()
+        rc = p.wait()
+        end = timer()
+
+    if rc != 0:
+        errored += 1
+        print('{:35} [ERRORED (exit code {})]'.format(description, rc))
+        print(err.decode('utf-8', 'replace'))
+    elif out_head != expected_head or out_tail != expected_tail or out_size != expected_size:
+        failed += 1
+        print('{:35} [FAILED]'.format(description))
+        print(repr(out_head), repr(out_tail), out_size, expected_size)
+    else:
+        passed += 1
+        print('{:35} [PASSED] {:.3f} secs'.format(description, end-start))
+
+print("%d passed, %d failed, %d errored" % (passed, failed, errored))
+if (failed == 0 and errored == 0):
+    exit(0)
+else:
+    exit(1)